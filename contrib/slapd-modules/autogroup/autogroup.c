@@ -1262,6 +1262,7 @@ autogroup_response( Operation *op, SlapReply *rs )
 					etmp.e_name = op->o_req_dn;
 					etmp.e_nname = op->o_req_ndn;
 					etmp.e_attrs = attrs;
+					etmp.e_attrindex = NULL;
 					odn = op->o_dn;
 					ondn = op->o_ndn;
 					op->o_dn = op->o_bd->be_rootdn;
@@ -1397,6 +1398,7 @@ autogroup_response( Operation *op, SlapReply *rs )
 			etmp.e_name = op->o_req_dn;
 			etmp.e_nname = op->o_req_ndn;
 			etmp.e_attrs = attrs;
+			etmp.e_attrindex = NULL;
 			odn = op->o_dn;
 			ondn = op->o_ndn;
 			op->o_dn = op->o_bd->be_rootdn;
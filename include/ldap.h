@@ -164,6 +164,9 @@ LDAP_BEGIN_DECL
 #define LDAP_OPT_X_TLS_PEERKEY_HASH	0x6019
 #define LDAP_OPT_X_TLS_REQUIRE_SAN	0x601a
 #define LDAP_OPT_X_TLS_PROTOCOL_MAX	0x601b
+#define LDAP_OPT_X_TLS_KTLS			0x601c	/* OpenSSL only */
+#define LDAP_OPT_X_TLS_SESSION_CACHE	0x601d
+#define LDAP_OPT_X_TLS_TICKET_ROTATE	0x601e
 
 #define LDAP_OPT_X_TLS_NEVER	0
 #define LDAP_OPT_X_TLS_HARD		1
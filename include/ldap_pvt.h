@@ -471,6 +471,16 @@ LDAP_F (int) ldap_pvt_tls_get_endpoint LDAP_P(( void *ctx, struct berval *buf, i
 LDAP_F (const char *) ldap_pvt_tls_get_version LDAP_P(( void *ctx ));
 LDAP_F (const char *) ldap_pvt_tls_get_cipher LDAP_P(( void *ctx ));
 
+typedef struct ldap_pvt_tls_stats {
+	unsigned long ts_full;			/* full server handshakes */
+	unsigned long ts_resumed;		/* abbreviated server handshakes */
+	unsigned long ts_cache_hits;
+	unsigned long ts_cache_misses;
+	unsigned long ts_cache_entries;
+} ldap_pvt_tls_stats;
+
+LDAP_F (void) ldap_pvt_tls_get_stats LDAP_P(( ldap_pvt_tls_stats *ts ));
+
 LDAP_END_DECL
 
 /*
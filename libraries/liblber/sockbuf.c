@@ -638,6 +638,22 @@ sb_rdahead_read( Sockbuf_IO_Desc *sbiod, void *buf, ber_len_t len )
 
 	if ( len == 0 ) return bufptr;
 
+	/* The buffer is empty now. Don't bounce large reads through it,
+	 * read straight into the caller's buffer instead. */
+	if ( len >= p->buf_size ) {
+		for (;;) {
+			ret = LBER_SBIOD_READ_NEXT( sbiod, (char *) buf + bufptr, len );
+#ifdef EINTR
+			if ( ( ret < 0 ) && ( errno == EINTR ) ) continue;
+#endif
+			break;
+		}
+		if ( ret < 0 ) {
+			return ( bufptr ? bufptr : ret );
+		}
+		return bufptr + ret;
+	}
+
 	max = p->buf_size - p->buf_end;
 	ret = 0;
 	while ( max > 0 ) {
@@ -135,6 +135,7 @@ static const struct ol_attribute {
 
 #ifdef HAVE_OPENSSL
 	{0, ATTR_TLS,	"TLS_CRLCHECK",		NULL,	LDAP_OPT_X_TLS_CRLCHECK},
+	{0, ATTR_TLS,	"TLS_KTLS",			NULL,	LDAP_OPT_X_TLS_KTLS},
 #endif
 #ifdef HAVE_GNUTLS
 	{0, ATTR_TLS,	"TLS_CRLFILE",			NULL,	LDAP_OPT_X_TLS_CRLFILE},
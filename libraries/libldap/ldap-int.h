@@ -188,6 +188,9 @@ struct ldaptls {
 	char		*lt_ecname;		/* OpenSSL only */
 	int		lt_protocol_min;
 	int		lt_protocol_max;
+	int		lt_ktls;		/* OpenSSL only */
+	int		lt_sess_cache;
+	int		lt_ticket_rotate;
 	struct berval	lt_cacert;
 	struct berval	lt_cert;
 	struct berval	lt_key;
@@ -309,6 +312,9 @@ struct ldapoptions {
 #define ldo_tls_ciphersuite	ldo_tls_info.lt_ciphersuite
 #define ldo_tls_protocol_min	ldo_tls_info.lt_protocol_min
 #define ldo_tls_protocol_max	ldo_tls_info.lt_protocol_max
+#define ldo_tls_ktls	ldo_tls_info.lt_ktls
+#define ldo_tls_sess_cache	ldo_tls_info.lt_sess_cache
+#define ldo_tls_ticket_rotate	ldo_tls_info.lt_ticket_rotate
 #define ldo_tls_crlfile	ldo_tls_info.lt_crlfile
 #define ldo_tls_randfile	ldo_tls_info.lt_randfile
 #define ldo_tls_cacert	ldo_tls_info.lt_cacert
@@ -46,6 +46,7 @@ typedef int (TI_session_endpoint)(tls_session *sess, struct berval *buf, int is_
 typedef const char *(TI_session_name)(tls_session *s);
 typedef int (TI_session_peercert)(tls_session *s, struct berval *der);
 typedef int (TI_session_pinning)(LDAP *ld, tls_session *s, char *hashalg, struct berval *hash);
+typedef int (TI_session_resumed)(tls_session *s);
 
 typedef void (TI_thr_init)(void);
 
@@ -75,6 +76,7 @@ typedef struct tls_impl {
 	TI_session_name *ti_session_cipher;
 	TI_session_peercert *ti_session_peercert;
 	TI_session_pinning *ti_session_pinning;
+	TI_session_resumed *ti_session_resumed;
 
 	Sockbuf_IO *ti_sbio;
 
@@ -85,4 +87,12 @@ typedef struct tls_impl {
 
 extern tls_impl ldap_int_tls_impl;
 
+/* shared server session cache, see tls2.c */
+extern int ldap_int_tls_sc_init( int size );
+extern int ldap_int_tls_sc_store( struct berval *id, struct berval *data,
+	time_t expire );
+extern int ldap_int_tls_sc_fetch( struct berval *id, struct berval *data,
+	void *(*alloc)( size_t ) );
+extern void ldap_int_tls_sc_remove( struct berval *id );
+
 #endif /* _LDAP_TLS_H */
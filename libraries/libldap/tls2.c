@@ -97,6 +97,259 @@ tls_ctx_ref( tls_ctx *ctx )
 static ldap_pvt_thread_mutex_t tls_def_ctx_mutex;
 #endif
 
+/*
+ * Server-side session cache, shared by every context. It is split into
+ * stripes with their own lock so concurrent handshakes do not all
+ * serialize on a single mutex.
+ */
+#define TLS_SC_STRIPES	16
+
+typedef struct tls_sc_entry {
+	struct tls_sc_entry *se_hnext;		/* hash chain */
+	struct tls_sc_entry *se_older;		/* age list */
+	struct tls_sc_entry *se_newer;
+	unsigned se_hash;
+	time_t se_expire;
+	ber_len_t se_idlen;
+	ber_len_t se_datalen;
+	unsigned char se_buf[1];	/* id, followed by data */
+} tls_sc_entry;
+
+typedef struct tls_sc_stripe {
+#ifdef LDAP_R_COMPILE
+	ldap_pvt_thread_mutex_t ss_mutex;
+#endif
+	tls_sc_entry **ss_buckets;
+	tls_sc_entry *ss_oldest;
+	tls_sc_entry *ss_newest;
+	int ss_count;
+	unsigned long ss_hits;
+	unsigned long ss_misses;
+} tls_sc_stripe;
+
+static tls_sc_stripe tls_sc[TLS_SC_STRIPES];
+static unsigned tls_sc_nbuckets;	/* per stripe, power of 2 */
+static int tls_sc_max;			/* entries per stripe */
+
+#ifdef LDAP_R_COMPILE
+static ldap_pvt_thread_mutex_t tls_stats_mutex;
+#endif
+static unsigned long tls_stats_full;
+static unsigned long tls_stats_resumed;
+
+static unsigned
+tls_sc_hash( struct berval *id )
+{
+	unsigned h = 2166136261U;
+	ber_len_t i;
+
+	for ( i = 0; i < id->bv_len; i++ ) {
+		h ^= (unsigned char)id->bv_val[i];
+		h *= 16777619U;
+	}
+	return h;
+}
+
+static void
+tls_sc_unlink( tls_sc_stripe *ss, tls_sc_entry *se )
+{
+	tls_sc_entry **prev;
+
+	for ( prev = &ss->ss_buckets[ ( se->se_hash / TLS_SC_STRIPES ) & ( tls_sc_nbuckets - 1 ) ];
+		*prev != se; prev = &(*prev)->se_hnext )
+		;
+	*prev = se->se_hnext;
+
+	if ( se->se_older )
+		se->se_older->se_newer = se->se_newer;
+	else
+		ss->ss_oldest = se->se_newer;
+	if ( se->se_newer )
+		se->se_newer->se_older = se->se_older;
+	else
+		ss->ss_newest = se->se_older;
+
+	ss->ss_count--;
+	LDAP_FREE( se );
+}
+
+static tls_sc_entry *
+tls_sc_find( tls_sc_stripe *ss, struct berval *id, unsigned hash )
+{
+	tls_sc_entry *se;
+
+	for ( se = ss->ss_buckets[ ( hash / TLS_SC_STRIPES ) & ( tls_sc_nbuckets - 1 ) ];
+		se; se = se->se_hnext )
+	{
+		if ( se->se_hash == hash && se->se_idlen == id->bv_len &&
+			!memcmp( se->se_buf, id->bv_val, id->bv_len ) )
+			break;
+	}
+	return se;
+}
+
+/*
+ * Size the cache to hold about size entries. The bucket arrays are only
+ * allocated once; later calls just adjust the per-stripe limit and let
+ * stores evict down to it.
+ */
+int
+ldap_int_tls_sc_init( int size )
+{
+	int i;
+
+	if ( size <= 0 )
+		return 0;
+
+	if ( !tls_sc_nbuckets ) {
+		unsigned n = 1;
+
+		while ( n < (unsigned)size / TLS_SC_STRIPES / 4 && n < 65536 )
+			n <<= 1;
+		for ( i = 0; i < TLS_SC_STRIPES; i++ ) {
+			tls_sc[i].ss_buckets = LDAP_CALLOC( n, sizeof( tls_sc_entry * ));
+			if ( !tls_sc[i].ss_buckets ) {
+				while ( --i >= 0 ) {
+					LDAP_FREE( tls_sc[i].ss_buckets );
+					tls_sc[i].ss_buckets = NULL;
+				}
+				return -1;
+			}
+		}
+		tls_sc_nbuckets = n;
+	}
+
+	tls_sc_max = ( size + TLS_SC_STRIPES - 1 ) / TLS_SC_STRIPES;
+	return 0;
+}
+
+int
+ldap_int_tls_sc_store( struct berval *id, struct berval *data, time_t expire )
+{
+	tls_sc_stripe *ss;
+	tls_sc_entry *se;
+	unsigned hash;
+
+	if ( !tls_sc_nbuckets || !tls_sc_max )
+		return -1;
+
+	se = LDAP_MALLOC( sizeof( tls_sc_entry ) + id->bv_len + data->bv_len );
+	if ( !se )
+		return -1;
+	hash = tls_sc_hash( id );
+	se->se_hash = hash;
+	se->se_expire = expire;
+	se->se_idlen = id->bv_len;
+	se->se_datalen = data->bv_len;
+	AC_MEMCPY( se->se_buf, id->bv_val, id->bv_len );
+	AC_MEMCPY( se->se_buf + id->bv_len, data->bv_val, data->bv_len );
+
+	ss = &tls_sc[ hash % TLS_SC_STRIPES ];
+	LDAP_MUTEX_LOCK( &ss->ss_mutex );
+	{
+		tls_sc_entry *old = tls_sc_find( ss, id, hash );
+		if ( old )
+			tls_sc_unlink( ss, old );
+	}
+	while ( ss->ss_count >= tls_sc_max && ss->ss_oldest )
+		tls_sc_unlink( ss, ss->ss_oldest );
+
+	se->se_hnext = ss->ss_buckets[ ( hash / TLS_SC_STRIPES ) & ( tls_sc_nbuckets - 1 ) ];
+	ss->ss_buckets[ ( hash / TLS_SC_STRIPES ) & ( tls_sc_nbuckets - 1 ) ] = se;
+	se->se_newer = NULL;
+	se->se_older = ss->ss_newest;
+	if ( ss->ss_newest )
+		ss->ss_newest->se_newer = se;
+	else
+		ss->ss_oldest = se;
+	ss->ss_newest = se;
+	ss->ss_count++;
+	LDAP_MUTEX_UNLOCK( &ss->ss_mutex );
+
+	return 0;
+}
+
+/*
+ * Copy a cached session into memory obtained from alloc, or from
+ * LDAP_MALLOC if alloc is NULL.
+ */
+int
+ldap_int_tls_sc_fetch( struct berval *id, struct berval *data,
+	void *(*alloc)( size_t ) )
+{
+	tls_sc_stripe *ss;
+	tls_sc_entry *se;
+	unsigned hash;
+	int rc = -1;
+
+	BER_BVZERO( data );
+	if ( !tls_sc_nbuckets )
+		return -1;
+
+	hash = tls_sc_hash( id );
+	ss = &tls_sc[ hash % TLS_SC_STRIPES ];
+	LDAP_MUTEX_LOCK( &ss->ss_mutex );
+	se = tls_sc_find( ss, id, hash );
+	if ( se && se->se_expire <= time( NULL ) ) {
+		tls_sc_unlink( ss, se );
+		se = NULL;
+	}
+	if ( se ) {
+		data->bv_val = alloc ? alloc( se->se_datalen ) :
+			LDAP_MALLOC( se->se_datalen );
+		if ( data->bv_val ) {
+			AC_MEMCPY( data->bv_val, se->se_buf + se->se_idlen,
+				se->se_datalen );
+			data->bv_len = se->se_datalen;
+			rc = 0;
+		}
+	}
+	if ( rc == 0 ) {
+		ss->ss_hits++;
+	} else {
+		ss->ss_misses++;
+	}
+	LDAP_MUTEX_UNLOCK( &ss->ss_mutex );
+
+	return rc;
+}
+
+void
+ldap_int_tls_sc_remove( struct berval *id )
+{
+	tls_sc_stripe *ss;
+	tls_sc_entry *se;
+	unsigned hash;
+
+	if ( !tls_sc_nbuckets )
+		return;
+
+	hash = tls_sc_hash( id );
+	ss = &tls_sc[ hash % TLS_SC_STRIPES ];
+	LDAP_MUTEX_LOCK( &ss->ss_mutex );
+	se = tls_sc_find( ss, id, hash );
+	if ( se )
+		tls_sc_unlink( ss, se );
+	LDAP_MUTEX_UNLOCK( &ss->ss_mutex );
+}
+
+static void
+tls_sc_destroy( void )
+{
+	int i;
+
+	for ( i = 0; i < TLS_SC_STRIPES; i++ ) {
+		tls_sc_stripe *ss = &tls_sc[i];
+
+		while ( ss->ss_oldest )
+			tls_sc_unlink( ss, ss->ss_oldest );
+		LDAP_FREE( ss->ss_buckets );
+		ss->ss_buckets = NULL;
+	}
+	tls_sc_nbuckets = 0;
+	tls_sc_max = 0;
+}
+
 void
 ldap_int_tls_destroy( struct ldapoptions *lo )
 {
@@ -156,6 +409,7 @@ ldap_pvt_tls_destroy( void )
 	struct ldapoptions *lo = LDAP_INT_GLOBAL_OPT();   
 
 	ldap_int_tls_destroy( lo );
+	tls_sc_destroy();
 
 	tls_imp->ti_tls_destroy();
 }
@@ -171,7 +425,12 @@ tls_init(tls_impl *impl, int do_threads )
 
 	if ( !tls_initialized++ ) {
 #ifdef LDAP_R_COMPILE
+		int i;
+
 		ldap_pvt_thread_mutex_init( &tls_def_ctx_mutex );
+		ldap_pvt_thread_mutex_init( &tls_stats_mutex );
+		for ( i = 0; i < TLS_SC_STRIPES; i++ )
+			ldap_pvt_thread_mutex_init( &tls_sc[i].ss_mutex );
 #endif
 	}
 
@@ -498,9 +757,42 @@ ldap_pvt_tls_accept( Sockbuf *sb, void *ctx_arg )
 #endif
 		return -1;
 	}
+
+	LDAP_MUTEX_LOCK( &tls_stats_mutex );
+	if ( tls_imp->ti_session_resumed( ssl ) )
+		tls_stats_resumed++;
+	else
+		tls_stats_full++;
+	LDAP_MUTEX_UNLOCK( &tls_stats_mutex );
 	return 0;
 }
 
+/*
+ * Report server handshake and session cache counters.
+ */
+void
+ldap_pvt_tls_get_stats( ldap_pvt_tls_stats *ts )
+{
+	int i;
+
+	memset( ts, 0, sizeof( *ts ));
+
+	LDAP_MUTEX_LOCK( &tls_stats_mutex );
+	ts->ts_full = tls_stats_full;
+	ts->ts_resumed = tls_stats_resumed;
+	LDAP_MUTEX_UNLOCK( &tls_stats_mutex );
+
+	for ( i = 0; i < TLS_SC_STRIPES; i++ ) {
+		tls_sc_stripe *ss = &tls_sc[i];
+
+		LDAP_MUTEX_LOCK( &ss->ss_mutex );
+		ts->ts_cache_hits += ss->ss_hits;
+		ts->ts_cache_misses += ss->ss_misses;
+		ts->ts_cache_entries += ss->ss_count;
+		LDAP_MUTEX_UNLOCK( &ss->ss_mutex );
+	}
+}
+
 int
 ldap_pvt_tls_inplace ( Sockbuf *sb )
 {
@@ -633,6 +925,16 @@ ldap_pvt_tls_config( LDAP *ld, int option, const char *arg )
 		}
 		return ldap_pvt_tls_set_option( ld, option, &i );
 		}
+	case LDAP_OPT_X_TLS_SESSION_CACHE:
+	case LDAP_OPT_X_TLS_TICKET_ROTATE: {
+		char *next;
+		long l;
+		l = strtol( arg, &next, 10 );
+		if ( l < 0 || l > 0x7fffffffL || next == arg || *next != '\0' )
+			return -1;
+		i = l;
+		return ldap_pvt_tls_set_option( ld, option, &i );
+		}
 #ifdef HAVE_OPENSSL
 	case LDAP_OPT_X_TLS_CRLCHECK:	/* OpenSSL only */
 		i = -1;
@@ -647,6 +949,23 @@ ldap_pvt_tls_config( LDAP *ld, int option, const char *arg )
 			return ldap_pvt_tls_set_option( ld, option, &i );
 		}
 		return -1;
+	case LDAP_OPT_X_TLS_KTLS:	/* OpenSSL only */
+		i = -1;
+		if ( ( strcasecmp( arg, "on" ) == 0 ) ||
+			( strcasecmp( arg, "yes" ) == 0 ) ||
+			( strcasecmp( arg, "true" ) == 0 ) )
+		{
+			i = 1;
+		} else if ( ( strcasecmp( arg, "off" ) == 0 ) ||
+			( strcasecmp( arg, "no" ) == 0 ) ||
+			( strcasecmp( arg, "false" ) == 0 ) )
+		{
+			i = 0;
+		}
+		if (i >= 0) {
+			return ldap_pvt_tls_set_option( ld, option, &i );
+		}
+		return -1;
 #endif
 	}
 	return -1;
@@ -727,6 +1046,9 @@ ldap_pvt_tls_get_option( LDAP *ld, int option, void *arg )
 	case LDAP_OPT_X_TLS_CRLCHECK:	/* OpenSSL only */
 		*(int *)arg = lo->ldo_tls_crlcheck;
 		break;
+	case LDAP_OPT_X_TLS_KTLS:	/* OpenSSL only */
+		*(int *)arg = lo->ldo_tls_ktls;
+		break;
 #endif
 	case LDAP_OPT_X_TLS_CIPHER_SUITE:
 		*(char **)arg = lo->ldo_tls_ciphersuite ?
@@ -738,6 +1060,12 @@ ldap_pvt_tls_get_option( LDAP *ld, int option, void *arg )
 	case LDAP_OPT_X_TLS_PROTOCOL_MAX:
 		*(int *)arg = lo->ldo_tls_protocol_max;
 		break;
+	case LDAP_OPT_X_TLS_SESSION_CACHE:
+		*(int *)arg = lo->ldo_tls_sess_cache;
+		break;
+	case LDAP_OPT_X_TLS_TICKET_ROTATE:
+		*(int *)arg = lo->ldo_tls_ticket_rotate;
+		break;
 	case LDAP_OPT_X_TLS_RANDOM_FILE:
 		*(char **)arg = lo->ldo_tls_randfile ?
 			LDAP_STRDUP( lo->ldo_tls_randfile ) : NULL;
@@ -955,6 +1283,10 @@ ldap_pvt_tls_set_option( LDAP *ld, int option, void *arg )
 			return 0;
 		}
 		return -1;
+	case LDAP_OPT_X_TLS_KTLS:	/* OpenSSL only */
+		if ( !arg ) return -1;
+		lo->ldo_tls_ktls = *(int *)arg ? 1 : 0;
+		return 0;
 #endif
 	case LDAP_OPT_X_TLS_CIPHER_SUITE:
 		if ( lo->ldo_tls_ciphersuite ) LDAP_FREE( lo->ldo_tls_ciphersuite );
@@ -969,6 +1301,14 @@ ldap_pvt_tls_set_option( LDAP *ld, int option, void *arg )
 		if ( !arg ) return -1;
 		lo->ldo_tls_protocol_max = *(int *)arg;
 		return 0;
+	case LDAP_OPT_X_TLS_SESSION_CACHE:
+		if ( !arg || *(int *)arg < 0 ) return -1;
+		lo->ldo_tls_sess_cache = *(int *)arg;
+		return 0;
+	case LDAP_OPT_X_TLS_TICKET_ROTATE:
+		if ( !arg || *(int *)arg < 0 ) return -1;
+		lo->ldo_tls_ticket_rotate = *(int *)arg;
+		return 0;
 	case LDAP_OPT_X_TLS_RANDOM_FILE:
 		if ( ld != NULL )
 			return -1;
@@ -53,6 +53,9 @@ typedef struct tlsg_ctx {
 	int refcount;
 	int reqcert;
 	gnutls_priority_t prios;
+	int sess_cache;
+	int ticket_rotate;
+	gnutls_datum_t ticket_key;
 #ifdef LDAP_R_COMPILE
 	ldap_pvt_thread_mutex_t ref_mutex;
 #endif
@@ -141,6 +144,10 @@ tlsg_ctx_free ( tls_ctx *ctx )
 	gnutls_certificate_free_credentials( c->cred );
 	if ( c->dh_params )
 		gnutls_dh_params_deinit( c->dh_params );
+	if ( c->ticket_key.data ) {
+		gnutls_memset( c->ticket_key.data, 0, c->ticket_key.size );
+		gnutls_free( c->ticket_key.data );
+	}
 	ber_memfree ( c );
 }
 
@@ -373,11 +380,68 @@ tlsg_ctx_init( struct ldapoptions *lo, struct ldaptls *lt, int is_server )
 		gnutls_certificate_set_dh_params( ctx->cred, ctx->dh_params );
 	}
 
+	if ( is_server && lo->ldo_tls_sess_cache &&
+		!ldap_int_tls_sc_init( lo->ldo_tls_sess_cache ))
+		ctx->sess_cache = 1;
+
+	/* GnuTLS derives the ticket encryption keys from this master key
+	 * and rotates them on its own once per ticket lifetime.
+	 */
+	if ( is_server && lo->ldo_tls_ticket_rotate ) {
+		if ( gnutls_session_ticket_key_generate( &ctx->ticket_key ))
+			return -1;
+		ctx->ticket_rotate = lo->ldo_tls_ticket_rotate;
+	}
+
 	ctx->reqcert = lo->ldo_tls_require_cert;
 
 	return 0;
 }
 
+static int
+tlsg_sc_store( void *ptr, gnutls_datum_t key, gnutls_datum_t data )
+{
+	struct berval id, bv;
+	time_t expire;
+
+#if GNUTLS_VERSION_NUMBER >= 0x030605
+	expire = gnutls_db_check_entry_expire_time( &data );
+#else
+	expire = time( NULL ) + gnutls_db_get_default_cache_expiration();
+#endif
+	id.bv_val = (char *)key.data;
+	id.bv_len = key.size;
+	bv.bv_val = (char *)data.data;
+	bv.bv_len = data.size;
+	return ldap_int_tls_sc_store( &id, &bv, expire );
+}
+
+static gnutls_datum_t
+tlsg_sc_fetch( void *ptr, gnutls_datum_t key )
+{
+	gnutls_datum_t data = { NULL, 0 };
+	struct berval id, bv;
+
+	id.bv_val = (char *)key.data;
+	id.bv_len = key.size;
+	if ( ldap_int_tls_sc_fetch( &id, &bv, gnutls_malloc ) == 0 ) {
+		data.data = (unsigned char *)bv.bv_val;
+		data.size = bv.bv_len;
+	}
+	return data;
+}
+
+static int
+tlsg_sc_remove( void *ptr, gnutls_datum_t key )
+{
+	struct berval id;
+
+	id.bv_val = (char *)key.data;
+	id.bv_len = key.size;
+	ldap_int_tls_sc_remove( &id );
+	return 0;
+}
+
 static tls_session *
 tlsg_session_new ( tls_ctx * ctx, int is_server )
 {
@@ -403,6 +467,18 @@ tlsg_session_new ( tls_ctx * ctx, int is_server )
 				flag = GNUTLS_CERT_REQUIRE;
 			gnutls_certificate_server_set_request( session->session, flag );
 		}
+		if ( c->sess_cache ) {
+			gnutls_db_set_retrieve_function( session->session, tlsg_sc_fetch );
+			gnutls_db_set_store_function( session->session, tlsg_sc_store );
+			gnutls_db_set_remove_function( session->session, tlsg_sc_remove );
+			gnutls_db_set_ptr( session->session, c );
+		}
+		if ( c->ticket_key.data ) {
+			gnutls_session_ticket_enable_server( session->session,
+				&c->ticket_key );
+			gnutls_db_set_cache_expiration( session->session,
+				c->ticket_rotate );
+		}
 	}
 	return (tls_session *)session;
 } 
@@ -447,6 +523,14 @@ tlsg_session_connect( LDAP *ld, tls_session *session, const char *name_in )
 	return tlsg_session_accept( session);
 }
 
+static int
+tlsg_session_resumed( tls_session *session )
+{
+	tlsg_session *s = (tlsg_session *)session;
+
+	return gnutls_session_is_resumed( s->session );
+}
+
 static int
 tlsg_session_upflags( Sockbuf *sb, tls_session *session, int rc )
 {
@@ -1243,6 +1327,7 @@ tls_impl ldap_int_tls_impl = {
 	tlsg_session_cipher,
 	tlsg_session_peercert,
 	tlsg_session_pinning,
+	tlsg_session_resumed,
 
 	&tlsg_sbio,
 
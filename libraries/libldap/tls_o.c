@@ -46,6 +46,10 @@
 #include <openssl/bn.h>
 #include <openssl/rsa.h>
 #include <openssl/dh.h>
+#include <openssl/hmac.h>
+#if OPENSSL_VERSION_NUMBER >= 0x30000000
+#include <openssl/core_names.h>
+#endif
 #endif
 
 #if OPENSSL_VERSION_NUMBER >= 0x10100000
@@ -60,6 +64,26 @@ static BIO_METHOD * tlso_bio_setup( void );
 
 static int  tlso_opt_trace = 1;
 
+/*
+ * Session ticket keys. The current key encrypts new tickets and is
+ * replaced once it is older than the rotation interval; the previous
+ * key is kept so tickets it issued can still be decrypted and renewed.
+ */
+typedef struct tlso_ticket_key {
+	unsigned char tk_name[16];
+	unsigned char tk_aes[32];
+	unsigned char tk_hmac[32];
+	time_t tk_created;
+} tlso_ticket_key;
+
+static tlso_ticket_key tlso_tkeys[2];
+static int tlso_tkey_rotate;
+#ifdef LDAP_R_COMPILE
+static ldap_pvt_thread_mutex_t tlso_tkey_mutex;
+#endif
+
+static void tlso_ktls_report( tlso_session *s );
+
 static void tlso_report_error( void );
 
 static void tlso_info_cb( const SSL *ssl, int where, int ret );
@@ -226,6 +250,9 @@ tlso_init( void )
 	X509V3_add_standard_extensions();
 
 	tlso_bio_method = tlso_bio_setup();
+#ifdef LDAP_R_COMPILE
+	ldap_pvt_thread_mutex_init( &tlso_tkey_mutex );
+#endif
 
 	return 0;
 }
@@ -250,6 +277,11 @@ tlso_destroy( void )
 		LDAP_FREE( lo->ldo_tls_randfile );
 		lo->ldo_tls_randfile = NULL;
 	}
+
+	OPENSSL_cleanse( tlso_tkeys, sizeof( tlso_tkeys ));
+#ifdef LDAP_R_COMPILE
+	ldap_pvt_thread_mutex_destroy( &tlso_tkey_mutex );
+#endif
 }
 
 static tls_ctx *
@@ -345,6 +377,165 @@ tlso_ctx_cipher13( tlso_ctx *ctx, char *suites )
 }
 #endif /* OpenSSL 1.1.1 */
 
+/*
+ * Server session cache callbacks. Sessions are kept DER encoded in the
+ * shared cache in tls2.c rather than in OpenSSL's per-context table.
+ */
+#if OPENSSL_VERSION_NUMBER < 0x10100000
+#define TLSO_SC_CONST
+#else
+#define TLSO_SC_CONST	const
+#endif
+
+static int
+tlso_sc_new_cb( SSL *s, SSL_SESSION *sess )
+{
+	struct berval id, data;
+	unsigned int idlen;
+	unsigned char *p;
+	int len;
+
+	len = i2d_SSL_SESSION( sess, NULL );
+	if ( len <= 0 )
+		return 0;
+	data.bv_val = LDAP_MALLOC( len );
+	if ( !data.bv_val )
+		return 0;
+	p = (unsigned char *)data.bv_val;
+	data.bv_len = i2d_SSL_SESSION( sess, &p );
+
+	id.bv_val = (char *)SSL_SESSION_get_id( sess, &idlen );
+	id.bv_len = idlen;
+	ldap_int_tls_sc_store( &id, &data,
+		SSL_SESSION_get_time( sess ) + SSL_SESSION_get_timeout( sess ));
+	LDAP_FREE( data.bv_val );
+
+	/* we did not keep a reference */
+	return 0;
+}
+
+static SSL_SESSION *
+tlso_sc_get_cb( SSL *s, TLSO_SC_CONST unsigned char *sid, int sidlen, int *copy )
+{
+	struct berval id, data;
+	SSL_SESSION *sess = NULL;
+
+	*copy = 0;
+	id.bv_val = (char *)sid;
+	id.bv_len = sidlen;
+	if ( ldap_int_tls_sc_fetch( &id, &data, NULL ) == 0 ) {
+		const unsigned char *p = (const unsigned char *)data.bv_val;
+		sess = d2i_SSL_SESSION( NULL, &p, data.bv_len );
+		LDAP_FREE( data.bv_val );
+	}
+	return sess;
+}
+
+static void
+tlso_sc_remove_cb( SSL_CTX *ctx, SSL_SESSION *sess )
+{
+	struct berval id;
+	unsigned int idlen;
+
+	id.bv_val = (char *)SSL_SESSION_get_id( sess, &idlen );
+	id.bv_len = idlen;
+	ldap_int_tls_sc_remove( &id );
+}
+
+/*
+ * Copy the key to encrypt with (name == NULL) or the key with the given
+ * name into tk. Returns 1 for the current key, 2 for the previous one
+ * and 0 if there is no usable key.
+ */
+static int
+tlso_ticket_key_get( const unsigned char *name, tlso_ticket_key *tk )
+{
+	time_t now = time( NULL );
+	int i, rc = 0;
+
+	LDAP_MUTEX_LOCK( &tlso_tkey_mutex );
+	if ( !tlso_tkeys[0].tk_created ||
+		now - tlso_tkeys[0].tk_created >= tlso_tkey_rotate )
+	{
+		tlso_ticket_key nk;
+
+		if ( RAND_bytes( nk.tk_name, sizeof( nk.tk_name )) > 0 &&
+			RAND_bytes( nk.tk_aes, sizeof( nk.tk_aes )) > 0 &&
+			RAND_bytes( nk.tk_hmac, sizeof( nk.tk_hmac )) > 0 )
+		{
+			nk.tk_created = now;
+			tlso_tkeys[1] = tlso_tkeys[0];
+			tlso_tkeys[0] = nk;
+		}
+		OPENSSL_cleanse( &nk, sizeof( nk ));
+	}
+	for ( i = 0; i < 2; i++ ) {
+		if ( !tlso_tkeys[i].tk_created )
+			break;
+		if ( !name || !memcmp( name, tlso_tkeys[i].tk_name,
+			sizeof( tlso_tkeys[i].tk_name )))
+		{
+			*tk = tlso_tkeys[i];
+			rc = i + 1;
+			break;
+		}
+	}
+	LDAP_MUTEX_UNLOCK( &tlso_tkey_mutex );
+
+	return rc;
+}
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000
+static int
+tlso_ticket_key_cb( SSL *s, unsigned char *name, unsigned char *iv,
+	EVP_CIPHER_CTX *ectx, EVP_MAC_CTX *hctx, int enc )
+#else
+static int
+tlso_ticket_key_cb( SSL *s, unsigned char *name, unsigned char *iv,
+	EVP_CIPHER_CTX *ectx, HMAC_CTX *hctx, int enc )
+#endif
+{
+	tlso_ticket_key tk;
+	int rc;
+
+	if ( enc ) {
+		rc = tlso_ticket_key_get( NULL, &tk );
+		if ( !rc )
+			return -1;
+		AC_MEMCPY( name, tk.tk_name, sizeof( tk.tk_name ));
+		if ( RAND_bytes( iv, EVP_CIPHER_iv_length( EVP_aes_256_cbc() )) <= 0 ||
+			!EVP_EncryptInit_ex( ectx, EVP_aes_256_cbc(), NULL, tk.tk_aes, iv ))
+			rc = -1;
+	} else {
+		rc = tlso_ticket_key_get( name, &tk );
+		if ( !rc )
+			return 0;
+		if ( !EVP_DecryptInit_ex( ectx, EVP_aes_256_cbc(), NULL, tk.tk_aes, iv ))
+			rc = -1;
+	}
+	if ( rc > 0 ) {
+#if OPENSSL_VERSION_NUMBER >= 0x30000000
+		OSSL_PARAM params[3];
+
+		params[0] = OSSL_PARAM_construct_octet_string( OSSL_MAC_PARAM_KEY,
+			tk.tk_hmac, sizeof( tk.tk_hmac ));
+		params[1] = OSSL_PARAM_construct_utf8_string( OSSL_MAC_PARAM_DIGEST,
+			"SHA256", 0 );
+		params[2] = OSSL_PARAM_construct_end();
+		if ( !EVP_MAC_CTX_set_params( hctx, params ))
+			rc = -1;
+#else
+		if ( !HMAC_Init_ex( hctx, tk.tk_hmac, sizeof( tk.tk_hmac ),
+			EVP_sha256(), NULL ))
+			rc = -1;
+#endif
+	}
+	OPENSSL_cleanse( &tk, sizeof( tk ));
+
+	/* 2 asks OpenSSL to reissue the ticket under the current key */
+	return rc;
+}
+
 /*
  * initialize a new TLS context
  */
@@ -357,6 +548,25 @@ tlso_ctx_init( struct ldapoptions *lo, struct ldaptls *lt, int is_server )
 	if ( is_server ) {
 		SSL_CTX_set_session_id_context( ctx,
 			(const unsigned char *) "OpenLDAP", sizeof("OpenLDAP")-1 );
+
+		if ( lo->ldo_tls_sess_cache &&
+			!ldap_int_tls_sc_init( lo->ldo_tls_sess_cache ))
+		{
+			SSL_CTX_set_session_cache_mode( ctx,
+				SSL_SESS_CACHE_SERVER | SSL_SESS_CACHE_NO_INTERNAL );
+			SSL_CTX_sess_set_new_cb( ctx, tlso_sc_new_cb );
+			SSL_CTX_sess_set_get_cb( ctx, tlso_sc_get_cb );
+			SSL_CTX_sess_set_remove_cb( ctx, tlso_sc_remove_cb );
+		}
+
+		if ( lo->ldo_tls_ticket_rotate ) {
+			tlso_tkey_rotate = lo->ldo_tls_ticket_rotate;
+#if OPENSSL_VERSION_NUMBER >= 0x30000000
+			SSL_CTX_set_tlsext_ticket_key_evp_cb( ctx, tlso_ticket_key_cb );
+#else
+			SSL_CTX_set_tlsext_ticket_key_cb( ctx, tlso_ticket_key_cb );
+#endif
+		}
 	}
 
 	if ( lo->ldo_tls_protocol_min ) {
@@ -603,6 +813,14 @@ tlso_ctx_init( struct ldapoptions *lo, struct ldaptls *lt, int is_server )
 	}
 	/* Explicitly honor the server side cipher suite preference */
 	SSL_CTX_set_options( ctx, SSL_OP_CIPHER_SERVER_PREFERENCE );
+#ifdef SSL_OP_ENABLE_KTLS
+	/* OpenSSL silently falls back to userspace record processing
+	 * if the kernel or the negotiated cipher lack kTLS support.
+	 */
+	if ( lo->ldo_tls_ktls ) {
+		SSL_CTX_set_options( ctx, SSL_OP_ENABLE_KTLS );
+	}
+#endif
 	return 0;
 }
 
@@ -628,6 +846,8 @@ tlso_session_connect( LDAP *ld, tls_session *sess, const char *name_in )
 #endif
 	/* Caller expects 0 = success, OpenSSL returns 1 = success */
 	rc = SSL_connect( s ) - 1;
+	if ( rc == 0 )
+		tlso_ktls_report( s );
 	return rc;
 }
 
@@ -635,9 +855,21 @@ static int
 tlso_session_accept( tls_session *sess )
 {
 	tlso_session *s = (tlso_session *)sess;
+	int rc;
 
 	/* Caller expects 0 = success, OpenSSL returns 1 = success */
-	return SSL_accept( s ) - 1;
+	rc = SSL_accept( s ) - 1;
+	if ( rc == 0 )
+		tlso_ktls_report( s );
+	return rc;
+}
+
+static int
+tlso_session_resumed( tls_session *sess )
+{
+	tlso_session *s = (tlso_session *)sess;
+
+	return SSL_session_reused( s );
 }
 
 static int
@@ -1282,6 +1514,41 @@ tlso_bio_setup( void )
 	return method;
 }
 
+#ifdef SSL_OP_ENABLE_KTLS
+/*
+ * Kernel TLS requires OpenSSL to own the socket through a socket BIO.
+ * That is only safe if nothing but the plain TCP layer sits below us in
+ * the Sockbuf, apart from debug layers (which only log the ciphertext)
+ * and empty readahead buffers.
+ */
+static int
+tlso_sb_is_socket( Sockbuf_IO_Desc *sbiod )
+{
+	for ( ; sbiod; sbiod = sbiod->sbiod_next ) {
+		if ( sbiod->sbiod_io == &ber_sockbuf_io_debug )
+			continue;
+		if ( sbiod->sbiod_io != &ber_sockbuf_io_readahead )
+			break;
+		if ( sbiod->sbiod_io->sbi_ctrl( sbiod, LBER_SB_OPT_DATA_READY, NULL ) )
+			return 0;
+	}
+	return sbiod && sbiod->sbiod_io == &ber_sockbuf_io_tcp &&
+		sbiod->sbiod_sb->sb_fd != AC_SOCKET_INVALID;
+}
+#endif
+
+static void
+tlso_ktls_report( tlso_session *s )
+{
+#if defined(SSL_OP_ENABLE_KTLS) && defined(BIO_get_ktls_send)
+	if ( SSL_get_options( s ) & SSL_OP_ENABLE_KTLS ) {
+		Debug2( LDAP_DEBUG_TRACE, "TLS: kernel offload send=%s recv=%s\n",
+			BIO_get_ktls_send( SSL_get_wbio( s )) ? "on" : "off",
+			BIO_get_ktls_recv( SSL_get_rbio( s )) ? "on" : "off" );
+	}
+#endif
+}
+
 static int
 tlso_sb_setup( Sockbuf_IO_Desc *sbiod, void *arg )
 {
@@ -1297,8 +1564,19 @@ tlso_sb_setup( Sockbuf_IO_Desc *sbiod, void *arg )
 	
 	p->session = arg;
 	p->sbiod = sbiod;
-	bio = BIO_new( tlso_bio_method );
-	BIO_set_data( bio, p );
+#ifdef SSL_OP_ENABLE_KTLS
+	if (( SSL_get_options( p->session ) & SSL_OP_ENABLE_KTLS ) &&
+		tlso_sb_is_socket( sbiod->sbiod_next ))
+	{
+		/* records are handled by the kernel once the handshake
+		 * completes; this layer only passes plaintext through */
+		bio = BIO_new_socket( sbiod->sbiod_sb->sb_fd, BIO_NOCLOSE );
+	} else
+#endif
+	{
+		bio = BIO_new( tlso_bio_method );
+		BIO_set_data( bio, p );
+	}
 	SSL_set_bio( p->session, bio, bio );
 	sbiod->sbiod_pvt = p;
 	return 0;
@@ -1673,6 +1951,7 @@ tls_impl ldap_int_tls_impl = {
 	tlso_session_cipher,
 	tlso_session_peercert,
 	tlso_session_pinning,
+	tlso_session_resumed,
 
 	&tlso_sbio,
 
@@ -102,13 +102,58 @@ void ucstr2upper(
 	}
 }
 
+/*
+ * Most values are plain ASCII, so the ASCII runs are scanned and
+ * case-folded a machine word at a time.  Words are loaded with
+ * memcpy() since values need not be aligned.
+ */
+typedef unsigned long ucword;
+
+#define UCW_ONES	( (ucword)~0UL / 0xff )
+#define UCW_HIGHS	( UCW_ONES * 0x80 )
+
+/* length of the leading run of ASCII bytes of s */
+static ber_len_t
+ucstr_ascii_span( const char *s, ber_len_t len )
+{
+	ber_len_t i = 0;
+	ucword w;
+
+	for ( ; i + sizeof(w) <= len; i += sizeof(w) ) {
+		memcpy( &w, s + i, sizeof(w) );
+		if ( w & UCW_HIGHS ) break;
+	}
+	for ( ; i < len && LDAP_UTF8_ISASCII( s + i ); i++ )
+		;
+	return i;
+}
+
+/* copy len ASCII bytes from src to dst, mapping A-Z to a-z */
+static void
+ucstr_ascii_lower( char *dst, const char *src, ber_len_t len )
+{
+	ber_len_t i = 0;
+	ucword w, ge_a, gt_z;
+
+	for ( ; i + sizeof(w) <= len; i += sizeof(w) ) {
+		memcpy( &w, src + i, sizeof(w) );
+		/* no byte is >= 0x80, so these additions cannot carry over */
+		ge_a = w + UCW_ONES * ( 0x80 - 'A' );
+		gt_z = w + UCW_ONES * ( 0x80 - 'Z' - 1 );
+		w |= ( ( ge_a & ~gt_z ) & UCW_HIGHS ) >> 2;
+		memcpy( dst + i, &w, sizeof(w) );
+	}
+	for ( ; i < len; i++ )
+		dst[i] = TOLOWER( src[i] );
+}
+
 struct berval * UTF8bvnormalize(
 	struct berval *bv,
 	struct berval *newbv,
 	unsigned flags,
 	void *ctx )
 {
-	int i, j, len, clen, outpos, ucsoutlen, outsize, last;
+	int i, j, len, clen, outpos, ucsoutlen, outsize, last, n;
 	int didnewbv = 0;
 	char *out, *outtmp, *s;
 	ac_uint4 *ucs, *p, *ucsout;
@@ -142,44 +187,34 @@ struct berval * UTF8bvnormalize(
 	 */
 
 	/* finish off everything up to character before first non-ascii */
-	if ( LDAP_UTF8_ISASCII( s ) ) {
-		if ( casefold ) {
-			outsize = len + 7;
-			out = (char *) ber_memalloc_x( outsize, ctx );
-			if ( out == NULL ) {
+	i = ucstr_ascii_span( s, len );
+	if ( i > 0 ) {
+		if ( i == len && !casefold ) {
+			return ber_str2bv_x( s, len, 1, newbv, ctx );
+		}
+
+		outsize = len + 7;
+		out = (char *) ber_memalloc_x( outsize, ctx );
+		if ( out == NULL ) {
 fail:
-				if ( didnewbv )
-					ber_memfree_x( newbv, ctx );
-				return NULL;
-			}
-			outpos = 0;
+			if ( didnewbv )
+				ber_memfree_x( newbv, ctx );
+			return NULL;
+		}
 
-			for ( i = 1; (i < len) && LDAP_UTF8_ISASCII(s + i); i++ ) {
-				out[outpos++] = TOLOWER( s[i-1] );
-			}
-			if ( i == len ) {
-				out[outpos++] = TOLOWER( s[len-1] );
-				out[outpos] = '\0';
-				newbv->bv_val = out;
-				newbv->bv_len = outpos;
-				return newbv;
-			}
-		} else {
-			for ( i = 1; (i < len) && LDAP_UTF8_ISASCII(s + i); i++ ) {
-				/* empty */
-			}
+		if ( i == len ) {
+			ucstr_ascii_lower( out, s, len );
+			out[len] = '\0';
+			newbv->bv_val = out;
+			newbv->bv_len = len;
+			return newbv;
+		}
 
-			if ( i == len ) {
-				return ber_str2bv_x( s, len, 1, newbv, ctx );
-			}
-				
-			outsize = len + 7;
-			out = (char *) ber_memalloc_x( outsize, ctx );
-			if ( out == NULL ) {
-				goto fail;
-			}
-			outpos = i - 1;
-			memcpy(out, s, outpos);
+		outpos = i - 1;
+		if ( casefold ) {
+			ucstr_ascii_lower( out, s, outpos );
+		} else {
+			memcpy( out, s, outpos );
 		}
 	} else {
 		outsize = len + 7;
@@ -287,11 +322,18 @@ fail:
 
 		/* s[i] is ascii */
 		/* finish off everything up to char before next non-ascii */
-		for ( i++; (i < len) && LDAP_UTF8_ISASCII(s + i); i++ ) {
-			out[outpos++] = casefold ? TOLOWER( s[i-1] ) : s[i-1];
+		n = ucstr_ascii_span( s + i, len - i );
+		i += n;
+		if ( i < len ) {
+			n--;
+		}
+		if ( casefold ) {
+			ucstr_ascii_lower( out + outpos, s + last, n );
+		} else {
+			memcpy( out + outpos, s + last, n );
 		}
+		outpos += n;
 		if ( i == len ) {
-			out[outpos++] = casefold ? TOLOWER( s[len-1] ) : s[len-1];
 			break;
 		}
 
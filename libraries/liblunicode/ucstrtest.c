@@ -0,0 +1,141 @@
+/* ucstrtest.c -- OpenLDAP UTF8bvnormalize Test Program */
+/* $OpenLDAP$ */
+/* This work is part of OpenLDAP Software <http://www.openldap.org/>.
+ *
+ * Copyright 1998-2022 The OpenLDAP Foundation.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted only as authorized by the OpenLDAP
+ * Public License.
+ *
+ * A copy of this license is available in the file LICENSE in the
+ * top-level directory of the distribution or, alternatively, at
+ * <http://www.OpenLDAP.org/license.html>.
+ */
+
+/*
+ * This program checks that UTF8bvnormalize, which scans and case-folds
+ * ASCII runs a word at a time, gives the same result as folding one
+ * byte at a time.  Random mixes of ASCII runs and non-ASCII characters
+ * are normalized at every alignment, with and without case folding.
+ * The non-ASCII characters used are precomposed and do not combine
+ * with their neighbours, so the expected result can be built character
+ * by character.
+ *
+ * Usage: ucstrtest [iterations [seed]]
+ */
+#include "portable.h"
+
+#include <stdio.h>
+
+#include <ac/ctype.h>
+#include <ac/stdlib.h>
+#include <ac/string.h>
+
+#include <lber.h>
+#include <ldap_pvt_uc.h>
+
+static const struct {
+	const char *in, *folded;
+} nonascii[] = {
+	{ "\xc3\x84", "\xc3\xa4" },		/* LATIN CAPITAL LETTER A WITH DIAERESIS */
+	{ "\xc3\xa9", "\xc3\xa9" },		/* LATIN SMALL LETTER E WITH ACUTE */
+	{ "\xce\xa3", "\xcf\x83" },		/* GREEK CAPITAL LETTER SIGMA */
+	{ "\xe2\x82\xac", "\xe2\x82\xac" },	/* EURO SIGN */
+	{ "\xe4\xb8\xad", "\xe4\xb8\xad" },	/* CJK UNIFIED IDEOGRAPH-4E2D */
+};
+#define NNONASCII	( sizeof(nonascii) / sizeof(nonascii[0]) )
+
+/* room for the longest input, at any alignment */
+#define MAXLEN	512
+
+static int
+check( const char *in, ber_len_t len, const char *expect, unsigned flags )
+{
+	struct berval bv, out;
+	int rc = 0;
+
+	bv.bv_val = (char *)in;
+	bv.bv_len = len;
+	if ( UTF8bvnormalize( &bv, &out, flags, NULL ) == NULL ) {
+		fprintf( stderr, "UTF8bvnormalize failed on \"%.*s\"\n",
+			(int)len, in );
+		return 1;
+	}
+	if ( out.bv_len != strlen( expect ) ||
+		memcmp( out.bv_val, expect, out.bv_len ) != 0 ||
+		out.bv_val[out.bv_len] != '\0' )
+	{
+		fprintf( stderr, "%s mismatch:\n  in:     \"%.*s\"\n"
+			"  got:    \"%s\"\n  expect: \"%s\"\n",
+			flags & LDAP_UTF8_CASEFOLD ? "casefold" : "plain",
+			(int)len, in, out.bv_val, expect );
+		rc = 1;
+	}
+	ber_memfree( out.bv_val );
+	return rc;
+}
+
+int
+main( int argc, char *argv[] )
+{
+	char buf[MAXLEN + 8], plain[MAXLEN + 1], folded[MAXLEN + 1];
+	int i, iterations = 100000, failed = 0;
+	unsigned seed = 1;
+
+	if ( argc > 1 )
+		iterations = atoi( argv[1] );
+	if ( argc > 2 )
+		seed = strtoul( argv[2], NULL, 0 );
+	srand( seed );
+
+	for ( i = 0; i < iterations && failed < 10; i++ ) {
+		int off = i % 8;
+		ber_len_t len = 0, flen = 0;
+		char *s = buf + off;
+
+		/* alternate ASCII runs with single non-ASCII characters */
+		while ( len < MAXLEN - 64 ) {
+			int n = rand() % 40;
+
+			/* bias the bytes towards the edges of A-Z */
+			for ( ; n > 0; n-- ) {
+				int c;
+
+				switch ( rand() % 4 ) {
+				case 0:
+					c = "@AZ[`az{"[ rand() % 8 ];
+					break;
+				default:
+					c = 0x20 + rand() % 0x5f;
+					break;
+				}
+				s[len++] = c;
+				folded[flen++] = TOLOWER( c );
+			}
+			if ( rand() % 4 == 0 )
+				break;
+			n = rand() % NNONASCII;
+			memcpy( s + len, nonascii[n].in, strlen( nonascii[n].in ) );
+			len += strlen( nonascii[n].in );
+			memcpy( folded + flen, nonascii[n].folded,
+				strlen( nonascii[n].folded ) );
+			flen += strlen( nonascii[n].folded );
+		}
+		memcpy( plain, s, len );
+		plain[len] = '\0';
+		folded[flen] = '\0';
+
+		failed += check( s, len, plain, 0 );
+		failed += check( s, len, folded, LDAP_UTF8_CASEFOLD );
+	}
+
+	if ( failed ) {
+		fprintf( stderr, "ucstrtest: %d mismatches (seed %u)\n",
+			failed, seed );
+		return EXIT_FAILURE;
+	}
+	printf( "ucstrtest: %d strings OK\n", i );
+	return EXIT_SUCCESS;
+}
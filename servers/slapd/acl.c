@@ -54,7 +54,8 @@ static AccessControl * slap_acl_get(
 	struct berval *val,
 	AclRegexMatches *matches,
 	slap_mask_t *mask,
-	AccessControlState *state );
+	AccessControlState *state,
+	int *skipped );
 
 static slap_control_t slap_acl_mask(
 	AccessControl *ac,
@@ -131,6 +132,11 @@ slap_access_always_allowed(
 	(m)->val_count = MATCHES_VALMAXCOUNT( (m) );		\
 } while ( 0 /* CONSTCOND */ )
 
+#define ACL_DNCACHE_ISSET(s, i) \
+	( (s)->as_dn_miss[ (i) >> 3 ] & ( 1U << ( (i) & 7 ) ) )
+#define ACL_DNCACHE_SET(s, i) \
+	( (s)->as_dn_miss[ (i) >> 3 ] |= ( 1U << ( (i) & 7 ) ) )
+
 int
 slap_access_allowed(
 	Operation		*op,
@@ -142,7 +148,7 @@ slap_access_allowed(
 	slap_mask_t		*maskp )
 {
 	int				ret = 1;
-	int				count;
+	int				count = 0, first = 0, skipped = 0;
 	AccessControl			*a, *prev;
 
 #ifdef LDAP_DEBUG
@@ -230,18 +236,30 @@ slap_access_allowed(
 			state->as_fe_done--;
 		ACL_PRIV_ASSIGN( mask, state->as_vd_mask );
 	} else {
-		*state = state_init;
+		/* keep the DN cache, it does not depend on as_desc */
+		AC_MEMCPY( state, &state_init,
+			offsetof( AccessControlState, as_dn_e ) );
 
 		a = NULL;
 		count = 0;
 		ACL_PRIV_ASSIGN( mask, *maskp );
 	}
 
+	if ( state->as_dn_e != e || state->as_dn_ndn != e->e_ndn ||
+		state->as_dn_bd != op->o_bd )
+	{
+		state->as_dn_e = e;
+		state->as_dn_ndn = e->e_ndn;
+		state->as_dn_bd = op->o_bd;
+		memset( state->as_dn_miss, 0, sizeof( state->as_dn_miss ) );
+	}
+
 	MATCHES_MEMSET( &matches );
 	prev = a;
+	first = count;
 
 	while ( ( a = slap_acl_get( a, &count, op, e, desc, val,
-		&matches, &mask, state ) ) != NULL )
+		&matches, &mask, state, &skipped ) ) != NULL )
 	{
 		int i; 
 		int dnmaxcount = MATCHES_DNMAXCOUNT( &matches );
@@ -317,6 +335,11 @@ slap_access_allowed(
 		accessmask2str( mask, accessmaskbuf, 1 ) );
 
 done:
+	if ( count ) {
+		op->o_hdr->oh_acl_evals++;
+		op->o_hdr->oh_acl_rules += count - first - skipped;
+		op->o_hdr->oh_acl_skipped += skipped;
+	}
 	ACL_PRIV_ASSIGN( *maskp, mask );
 	return ret;
 }
@@ -489,6 +512,77 @@ done:
 }
 
 
+/*
+ * acl_dn_target - tell whether the "to" DN part of acl a
+ * selects entry e; regex submatches are stored in matches.
+ */
+static int
+acl_dn_target(
+	AccessControl	*a,
+	Entry		*e,
+	AclRegexMatches	*matches,
+	int		count )
+{
+	ber_len_t dnlen = e->e_nname.bv_len;
+
+	if ( a->acl_dn_style == ACL_STYLE_REGEX ) {
+		Debug( LDAP_DEBUG_ACL, "=> dnpat: [%d] %s nsub: %d\n", 
+			count, a->acl_dn_pat.bv_val, (int) a->acl_dn_re.re_nsub );
+		if ( regexec ( &a->acl_dn_re, 
+			       e->e_ndn, 
+		 	       matches->dn_count, 
+			       matches->dn_data, 0 ) )
+			return 0;
+
+	} else {
+		ber_len_t patlen;
+
+		Debug( LDAP_DEBUG_ACL, "=> dn: [%d] %s\n", 
+			count, a->acl_dn_pat.bv_val );
+		patlen = a->acl_dn_pat.bv_len;
+		if ( dnlen < patlen )
+			return 0;
+
+		if ( a->acl_dn_style == ACL_STYLE_BASE ) {
+			/* base dn -- entire object DN must match */
+			if ( dnlen != patlen )
+				return 0;
+
+		} else if ( a->acl_dn_style == ACL_STYLE_ONE ) {
+			ber_len_t	rdnlen = 0;
+			ber_len_t	sep = 0;
+
+			if ( dnlen <= patlen )
+				return 0;
+
+			if ( patlen > 0 ) {
+				if ( !DN_SEPARATOR( e->e_ndn[dnlen - patlen - 1] ) )
+					return 0;
+				sep = 1;
+			}
+
+			rdnlen = dn_rdnlen( NULL, &e->e_nname );
+			if ( rdnlen + patlen + sep != dnlen )
+				return 0;
+
+		} else if ( a->acl_dn_style == ACL_STYLE_SUBTREE ) {
+			if ( dnlen > patlen && !DN_SEPARATOR( e->e_ndn[dnlen - patlen - 1] ) )
+				return 0;
+
+		} else if ( a->acl_dn_style == ACL_STYLE_CHILDREN ) {
+			if ( dnlen <= patlen )
+				return 0;
+			if ( !DN_SEPARATOR( e->e_ndn[dnlen - patlen - 1] ) )
+				return 0;
+		}
+
+		if ( strcmp( a->acl_dn_pat.bv_val, e->e_ndn + dnlen - patlen ) != 0 )
+			return 0;
+	}
+
+	return 1;
+}
+
 /*
  * slap_acl_get - return the acl applicable to entry e, attribute
  * attr.  the acl returned is suitable for use in subsequent calls to
@@ -505,10 +599,10 @@ slap_acl_get(
 	struct berval	*val,
 	AclRegexMatches	*matches,
 	slap_mask_t *mask,
-	AccessControlState *state )
+	AccessControlState *state,
+	int *skipped )
 {
 	const char *attr;
-	ber_len_t dnlen;
 	AccessControl *prev;
 
 	assert( e != NULL );
@@ -536,8 +630,6 @@ slap_acl_get(
 		a = a->acl_next;
 	}
 
-	dnlen = e->e_nname.bv_len;
-
  retry:
 	for ( ; a != NULL; prev = a, a = a->acl_next ) {
 		(*count) ++;
@@ -546,59 +638,18 @@ slap_acl_get(
 			state->as_fe_done++;
 
 		if ( a->acl_dn_pat.bv_len || ( a->acl_dn_style != ACL_STYLE_REGEX )) {
-			if ( a->acl_dn_style == ACL_STYLE_REGEX ) {
-				Debug( LDAP_DEBUG_ACL, "=> dnpat: [%d] %s nsub: %d\n", 
-					*count, a->acl_dn_pat.bv_val, (int) a->acl_dn_re.re_nsub );
-				if ( regexec ( &a->acl_dn_re, 
-					       e->e_ndn, 
-				 	       matches->dn_count, 
-					       matches->dn_data, 0 ) )
-					continue;
-
-			} else {
-				ber_len_t patlen;
-
-				Debug( LDAP_DEBUG_ACL, "=> dn: [%d] %s\n", 
-					*count, a->acl_dn_pat.bv_val );
-				patlen = a->acl_dn_pat.bv_len;
-				if ( dnlen < patlen )
-					continue;
-
-				if ( a->acl_dn_style == ACL_STYLE_BASE ) {
-					/* base dn -- entire object DN must match */
-					if ( dnlen != patlen )
-						continue;
-
-				} else if ( a->acl_dn_style == ACL_STYLE_ONE ) {
-					ber_len_t	rdnlen = 0;
-					ber_len_t	sep = 0;
-
-					if ( dnlen <= patlen )
-						continue;
-
-					if ( patlen > 0 ) {
-						if ( !DN_SEPARATOR( e->e_ndn[dnlen - patlen - 1] ) )
-							continue;
-						sep = 1;
-					}
-
-					rdnlen = dn_rdnlen( NULL, &e->e_nname );
-					if ( rdnlen + patlen + sep != dnlen )
-						continue;
-
-				} else if ( a->acl_dn_style == ACL_STYLE_SUBTREE ) {
-					if ( dnlen > patlen && !DN_SEPARATOR( e->e_ndn[dnlen - patlen - 1] ) )
-						continue;
+			int	bit = *count - 1;
 
-				} else if ( a->acl_dn_style == ACL_STYLE_CHILDREN ) {
-					if ( dnlen <= patlen )
-						continue;
-					if ( !DN_SEPARATOR( e->e_ndn[dnlen - patlen - 1] ) )
-						continue;
-				}
+			/* the "to" DN part only depends on the entry DN */
+			if ( bit < SLAP_ACL_DNCACHE && ACL_DNCACHE_ISSET( state, bit ) ) {
+				(*skipped)++;
+				continue;
+			}
 
-				if ( strcmp( a->acl_dn_pat.bv_val, e->e_ndn + dnlen - patlen ) != 0 )
-					continue;
+			if ( !acl_dn_target( a, e, matches, *count ) ) {
+				if ( bit < SLAP_ACL_DNCACHE )
+					ACL_DNCACHE_SET( state, bit );
+				continue;
 			}
 
 			Debug( LDAP_DEBUG_ACL, "=> acl_get: [%d] matched\n",
@@ -1037,9 +1088,9 @@ acl_mask_dnattr(
 	bv = *opndn;
 
 	/* see if asker is listed in dnattr */
-	for ( at = attrs_find( e->e_attrs, bdn->a_at );
+	for ( at = entry_attrs_find( e, bdn->a_at );
 		at != NULL;
-		at = attrs_find( at->a_next, bdn->a_at ) )
+		at = entry_attrs_find_next( e, at, bdn->a_at ) )
 	{
 		if ( attr_valfind( at,
 			SLAP_MR_ATTRIBUTE_VALUE_NORMALIZED_MATCH |
@@ -1992,7 +2043,7 @@ acl_check_modlist(
 			assert( mlist->sml_values != NULL );
 
 			if ( mlist->sml_op == SLAP_MOD_ADD_IF_NOT_PRESENT
-				&& attr_find( e->e_attrs, mlist->sml_desc ) )
+				&& entry_attr_find( e, mlist->sml_desc ) )
 			{
 				break;
 			}
@@ -2130,7 +2181,7 @@ acl_set_cb_gather( Operation *op, SlapReply *rs )
 			} else {
 				Attribute	*a;
 
-				a = attr_find( rs->sr_entry->e_attrs, desc );
+				a = entry_attr_find( rs->sr_entry, desc );
 				if ( a != NULL ) {
 					bvalsp = a->a_nvals;
 				}
@@ -114,14 +114,16 @@ AttributeDescription * ad_find_tags(
 {
 	AttributeDescription *ad;
 
-	ldap_pvt_thread_mutex_lock( &type->sat_ad_mutex );
+	/* Descriptions are linked in fully built and never freed while
+	 * the server runs, so the list can be walked without the mutex,
+	 * as slap_bv2ad() does.
+	 */
 	for (ad = type->sat_ad; ad; ad=ad->ad_next)
 	{
 		if (ad->ad_tags.bv_len == tags->bv_len &&
 			!strcasecmp(ad->ad_tags.bv_val, tags->bv_val))
 			break;
 	}
-	ldap_pvt_thread_mutex_unlock( &type->sat_ad_mutex );
 	return ad;
 }
 
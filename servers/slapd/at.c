@@ -73,15 +73,13 @@ struct aindexrec {
 };
 
 static Avlnode	*attr_index = NULL;
-static Avlnode	*attr_cache = NULL;
+static SchemaHash	*attr_hash = NULL;
 static LDAP_STAILQ_HEAD(ATList, AttributeType) attr_list
 	= LDAP_STAILQ_HEAD_INITIALIZER(attr_list);
 
 /* Last hardcoded attribute registered */
 AttributeType *at_sys_tail;
 
-int at_oc_cache;
-
 static int
 attr_index_cmp(
     const void	*v_air1,
@@ -94,18 +92,6 @@ attr_index_cmp(
 	return (strcasecmp( air1->air_name.bv_val, air2->air_name.bv_val ));
 }
 
-static int
-attr_index_name_cmp(
-    const void	*v_type,
-    const void	*v_air )
-{
-    const struct berval    *type = v_type;
-    const struct aindexrec *air  = v_air;
-	int i = type->bv_len - air->air_name.bv_len;
-	if (i) return i;
-	return (strncasecmp( type->bv_val, air->air_name.bv_val, type->bv_len ));
-}
-
 AttributeType *
 at_find( const char *name )
 {
@@ -122,20 +108,11 @@ at_bvfind( struct berval *name )
 {
 	struct aindexrec *air;
 
-	if ( attr_cache ) {
-		air = ldap_avl_find( attr_cache, name, attr_index_name_cmp );
-		if ( air ) return air->air_at;
-	}
-
-	air = ldap_avl_find( attr_index, name, attr_index_name_cmp );
+	/* air_name is the first member of the record */
+	air = (struct aindexrec *)schema_hash_find( attr_hash, name );
 
-	if ( air ) {
-		if ( air->air_at->sat_flags & SLAP_AT_DELETED ) {
-			air = NULL;
-		} else if (( slapMode & SLAP_TOOL_MODE ) && at_oc_cache ) {
-			ldap_avl_insert( &attr_cache, (caddr_t) air,
-				attr_index_cmp, ldap_avl_dup_error );
-		}
+	if ( air && ( air->air_at->sat_flags & SLAP_AT_DELETED )) {
+		air = NULL;
 	}
 
 	return air != NULL ? air->air_at : NULL;
@@ -242,6 +219,7 @@ at_delete_names( AttributeType *at )
 		air = (struct aindexrec *)ldap_avl_delete( &attr_index,
 			(caddr_t)&tmpair, attr_index_cmp );
 		assert( air != NULL );
+		schema_hash_delete( &attr_hash, &air->air_name );
 		ldap_memfree( air );
 		names++;
 	}
@@ -258,6 +236,9 @@ at_delete( AttributeType *at )
 	LDAP_STAILQ_REMOVE(&attr_list, at, AttributeType, sat_next);
 
 	at_delete_names( at );
+
+	/* cached DNs may use it */
+	dn_cache_flush();
 }
 
 static void
@@ -326,6 +307,7 @@ at_destroy( void )
 	}
 
 	ldap_avl_free(attr_index, at_destroy_one);
+	schema_hash_free( &attr_hash );
 
 	if ( slap_schema.si_at_undefined ) {
 		ad_destroy(slap_schema.si_at_undefined->sat_ad);
@@ -503,6 +485,8 @@ at_insert(
 
 				return rc;
 			}
+		} else {
+			schema_hash_insert( &attr_hash, &air->air_name );
 		}
 		/* FIX: temporal consistency check */
 		at_bvfind( &air->air_name );
@@ -538,6 +522,7 @@ at_insert(
 					air = (struct aindexrec *)ldap_avl_delete( &attr_index,
 						(caddr_t)&tmpair, attr_index_cmp );
 					assert( air != NULL );
+					schema_hash_delete( &attr_hash, &air->air_name );
 					ldap_memfree( air );
 				}
 
@@ -549,11 +534,13 @@ at_insert(
 					air = (struct aindexrec *)ldap_avl_delete( &attr_index,
 						(caddr_t)&tmpair, attr_index_cmp );
 					assert( air != NULL );
+					schema_hash_delete( &attr_hash, &air->air_name );
 					ldap_memfree( air );
 				}
 
 				return rc;
 			}
+			schema_hash_insert( &attr_hash, &air->air_name );
 			/* FIX: temporal consistency check */
 			at_bvfind(&air->air_name);
 			names++;
@@ -582,6 +569,9 @@ at_insert(
 		LDAP_STAILQ_INSERT_TAIL( &attr_list, sat, sat_next );
 	}
 
+	/* cached DNs may have been normalized without it */
+	dn_cache_flush();
+
 	return 0;
 }
 
@@ -674,6 +674,143 @@ attr_find(
 	return( NULL );
 }
 
+static unsigned
+entry_attr_index_slots( int nattrs )
+{
+	unsigned n = 4;
+
+	/* keep the table at most half full */
+	while ( n < 2U * nattrs )
+		n <<= 1;
+	return n;
+}
+
+/*
+ * entry_attr_index_size - size of the table entry_attr_index()
+ * builds for an entry of nattrs attributes
+ */
+
+size_t
+entry_attr_index_size( int nattrs )
+{
+	return sizeof(AttrIndex) +
+		( entry_attr_index_slots( nattrs ) - 1 ) * sizeof(Attribute *);
+}
+
+/*
+ * entry_attr_index - build a lookup table for the nattrs attributes
+ * of e in buf, which must hold entry_attr_index_size( nattrs ) bytes
+ * and live as long as the entry. The entry must not have its
+ * attributes removed or reordered afterwards; appending to or
+ * replacing the list just disables the table.
+ */
+
+void
+entry_attr_index( Entry *e, void *buf, int nattrs )
+{
+	AttrIndex *ai = buf;
+	Attribute *a;
+	unsigned n = entry_attr_index_slots( nattrs ), i;
+
+	if ( e->e_attrs == NULL )
+		return;
+
+	memset( ai, 0, entry_attr_index_size( nattrs ) );
+	ai->ai_mask = n - 1;
+
+	for ( a = e->e_attrs; a != NULL; a = a->a_next ) {
+		if ( a->a_desc->ad_tags.bv_len || a->a_desc->ad_flags )
+			ai->ai_options = 1;
+		for ( i = a->a_desc->ad_index & ai->ai_mask; ai->ai_slots[i];
+			i = ( i + 1 ) & ai->ai_mask )
+		{
+			if ( ai->ai_slots[i]->a_desc == a->a_desc )
+				break;
+		}
+		if ( !ai->ai_slots[i] )
+			ai->ai_slots[i] = a;
+		ai->ai_last = a;
+	}
+
+	ai->ai_first = e->e_attrs;
+	e->e_attrindex = ai;
+}
+
+static Attribute *
+entry_attr_index_find( AttrIndex *ai, AttributeDescription *desc )
+{
+	unsigned i;
+
+	for ( i = desc->ad_index & ai->ai_mask; ai->ai_slots[i];
+		i = ( i + 1 ) & ai->ai_mask )
+	{
+		if ( ai->ai_slots[i]->a_desc == desc )
+			return ai->ai_slots[i];
+	}
+	return NULL;
+}
+
+#define ENTRY_ATTR_INDEX_OK( e ) \
+	( (e)->e_attrindex != NULL && \
+	(e)->e_attrindex->ai_first == (e)->e_attrs && \
+	(e)->e_attrindex->ai_last->a_next == NULL )
+
+/*
+ * entry_attr_find - same as attr_find( e->e_attrs, desc )
+ */
+
+Attribute *
+entry_attr_find(
+	Entry	*e,
+	AttributeDescription *desc )
+{
+	if ( ENTRY_ATTR_INDEX_OK( e ) )
+		return entry_attr_index_find( e->e_attrindex, desc );
+
+	return attr_find( e->e_attrs, desc );
+}
+
+/*
+ * The table only holds exact descriptions, so it can stand in for
+ * attrs_find() when no attribute of the entry can be a proper subtype
+ * of desc; then at most one attribute matches.
+ */
+#define ENTRY_ATTR_INDEX_EXACT( e, desc ) \
+	( ENTRY_ATTR_INDEX_OK( e ) && !(e)->e_attrindex->ai_options && \
+	(desc)->ad_type->sat_subtypes == NULL )
+
+/*
+ * entry_attrs_find - same as attrs_find( e->e_attrs, desc )
+ */
+
+Attribute *
+entry_attrs_find(
+	Entry	*e,
+	AttributeDescription *desc )
+{
+	if ( ENTRY_ATTR_INDEX_EXACT( e, desc ) )
+		return entry_attr_index_find( e->e_attrindex, desc );
+
+	return attrs_find( e->e_attrs, desc );
+}
+
+/*
+ * entry_attrs_find_next - same as attrs_find( a->a_next, desc ),
+ * for a returned by entry_attrs_find() or a previous call
+ */
+
+Attribute *
+entry_attrs_find_next(
+	Entry	*e,
+	Attribute	*a,
+	AttributeDescription *desc )
+{
+	if ( ENTRY_ATTR_INDEX_EXACT( e, desc ) )
+		return NULL;
+
+	return attrs_find( a->a_next, desc );
+}
+
 /*
  * attr_delete - delete the attribute type in list pointed to by attrs
  * return	0	deleted ok
@@ -83,6 +83,9 @@ struct mdb_info {
 	int			mi_readers;
 
 	unsigned	mi_rtxn_size;
+	unsigned	mi_attrtable;
+	unsigned	mi_indexcap;
+	int		mi_dedupnvals;
 	int			mi_txn_cp;
 	unsigned	mi_txn_cp_min;
 	unsigned	mi_txn_cp_kbyte;
@@ -127,6 +130,7 @@ typedef struct mdb_op_info {
 	OpExtra		moi_oe;
 	MDB_txn*	moi_txn;
 	int			moi_ref;
+	int			moi_numads;	/* SLAP_TXN: AttributeDescriptions known at begin */
 	char		moi_flag;
 } mdb_op_info;
 #define MOI_READER	0x01
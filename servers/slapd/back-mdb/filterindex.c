@@ -825,6 +825,107 @@ equality_candidates(
 }
 
 
+/* Intersect the posting lists of all keys into ids. Keys are read
+ * smallest first, and once there are candidates, keys larger than
+ * the database's indexcap are left to filter evaluation.
+ */
+static int
+keys_candidates(
+	Operation *op,
+	MDB_txn *rtxn,
+	MDB_dbi dbi,
+	struct berval *keys,
+	AttributeDescription *desc,
+	ID *ids,
+	ID *tmp )
+{
+	struct mdb_info *mdb = (struct mdb_info *) op->o_bd->be_private;
+	struct keyorder {
+		ID ko_count;
+		int ko_key;
+	} *order = NULL;
+	int i, j, n;
+	int rc = 0;
+
+	for ( n = 0; keys[n].bv_val != NULL; n++ )
+		;
+
+	if ( n > 1 ) {
+		order = op->o_tmpalloc( n * sizeof(struct keyorder), op->o_tmpmemctx );
+		for ( i = 0; i < n; i++ ) {
+			ID count;
+
+			rc = mdb_key_count( op->o_bd, rtxn, dbi, &keys[i], &count );
+			if ( rc == MDB_NOTFOUND ) {
+				MDB_IDL_ZERO( ids );
+				rc = 0;
+				goto done;
+			} else if ( rc != LDAP_SUCCESS ) {
+				Debug( LDAP_DEBUG_TRACE,
+					"<= mdb_keys_candidates: (%s) "
+					"key count failed (%d)\n",
+					desc->ad_cname.bv_val, rc );
+				goto done;
+			}
+
+			for ( j = i; j > 0 && order[j-1].ko_count > count; j-- )
+				order[j] = order[j-1];
+			order[j].ko_count = count;
+			order[j].ko_key = i;
+		}
+	}
+
+	for ( i = 0; i < n; i++ ) {
+		struct berval *key = order ? &keys[order[i].ko_key] : &keys[i];
+
+		if ( i > 0 && mdb->mi_indexcap &&
+			order[i].ko_count > mdb->mi_indexcap )
+		{
+			Debug( LDAP_DEBUG_TRACE,
+				"<= mdb_keys_candidates: (%s) "
+				"%d keys over indexcap skipped\n",
+				desc->ad_cname.bv_val, n - i );
+			break;
+		}
+
+		rc = mdb_key_read( op->o_bd, rtxn, dbi, key, tmp, NULL, 0 );
+
+		if( rc == MDB_NOTFOUND ) {
+			MDB_IDL_ZERO( ids );
+			rc = 0;
+			break;
+		} else if( rc != LDAP_SUCCESS ) {
+			Debug( LDAP_DEBUG_TRACE,
+				"<= mdb_keys_candidates: (%s) "
+				"key read failed (%d)\n",
+				desc->ad_cname.bv_val, rc );
+			break;
+		}
+
+		if( MDB_IDL_IS_ZERO( tmp ) ) {
+			Debug( LDAP_DEBUG_TRACE,
+				"<= mdb_keys_candidates: (%s) NULL\n",
+				desc->ad_cname.bv_val );
+			MDB_IDL_ZERO( ids );
+			break;
+		}
+
+		if ( i == 0 ) {
+			MDB_IDL_CPY( ids, tmp );
+		} else {
+			mdb_idl_intersection( ids, tmp );
+		}
+
+		if( MDB_IDL_IS_ZERO( ids ) )
+			break;
+	}
+
+done:
+	if ( order )
+		op->o_tmpfree( order, op->o_tmpmemctx );
+	return rc;
+}
+
 static int
 approx_candidates(
 	Operation *op,
@@ -834,7 +935,6 @@ approx_candidates(
 	ID *tmp )
 {
 	MDB_dbi	dbi;
-	int i;
 	int rc;
 	slap_mask_t mask;
 	struct berval prefix = {0, NULL};
@@ -902,38 +1002,7 @@ approx_candidates(
 		return 0;
 	}
 
-	for ( i= 0; keys[i].bv_val != NULL; i++ ) {
-		rc = mdb_key_read( op->o_bd, rtxn, dbi, &keys[i], tmp, NULL, 0 );
-
-		if( rc == MDB_NOTFOUND ) {
-			MDB_IDL_ZERO( ids );
-			rc = 0;
-			break;
-		} else if( rc != LDAP_SUCCESS ) {
-			Debug( LDAP_DEBUG_TRACE,
-				"<= mdb_approx_candidates: (%s) "
-				"key read failed (%d)\n",
-				ava->aa_desc->ad_cname.bv_val, rc );
-			break;
-		}
-
-		if( MDB_IDL_IS_ZERO( tmp ) ) {
-			Debug( LDAP_DEBUG_TRACE,
-				"<= mdb_approx_candidates: (%s) NULL\n",
-				ava->aa_desc->ad_cname.bv_val );
-			MDB_IDL_ZERO( ids );
-			break;
-		}
-
-		if ( i == 0 ) {
-			MDB_IDL_CPY( ids, tmp );
-		} else {
-			mdb_idl_intersection( ids, tmp );
-		}
-
-		if( MDB_IDL_IS_ZERO( ids ) )
-			break;
-	}
+	rc = keys_candidates( op, rtxn, dbi, keys, ava->aa_desc, ids, tmp );
 
 	ber_bvarray_free_x( keys, op->o_tmpmemctx );
 
@@ -953,7 +1022,6 @@ substring_candidates(
 	ID *tmp )
 {
 	MDB_dbi	dbi;
-	int i;
 	int rc;
 	slap_mask_t mask;
 	struct berval prefix = {0, NULL};
@@ -1017,38 +1085,7 @@ substring_candidates(
 		return 0;
 	}
 
-	for ( i= 0; keys[i].bv_val != NULL; i++ ) {
-		rc = mdb_key_read( op->o_bd, rtxn, dbi, &keys[i], tmp, NULL, 0 );
-
-		if( rc == MDB_NOTFOUND ) {
-			MDB_IDL_ZERO( ids );
-			rc = 0;
-			break;
-		} else if( rc != LDAP_SUCCESS ) {
-			Debug( LDAP_DEBUG_TRACE,
-				"<= mdb_substring_candidates: (%s) "
-				"key read failed (%d)\n",
-				sub->sa_desc->ad_cname.bv_val, rc );
-			break;
-		}
-
-		if( MDB_IDL_IS_ZERO( tmp ) ) {
-			Debug( LDAP_DEBUG_TRACE,
-				"<= mdb_substring_candidates: (%s) NULL\n",
-				sub->sa_desc->ad_cname.bv_val );
-			MDB_IDL_ZERO( ids );
-			break;
-		}
-
-		if ( i == 0 ) {
-			MDB_IDL_CPY( ids, tmp );
-		} else {
-			mdb_idl_intersection( ids, tmp );
-		}
-
-		if( MDB_IDL_IS_ZERO( ids ) )
-			break;
-	}
+	rc = keys_candidates( op, rtxn, dbi, keys, sub->sa_desc, ids, tmp );
 
 	ber_bvarray_free_x( keys, op->o_tmpmemctx );
 
@@ -28,6 +28,7 @@ typedef struct Ecount {
 	int nattrs;
 	int nvals;
 	int offset;
+	int nvsame;	/* use MDB_NVAL_SAME */
 	Attribute *multi;
 } Ecount;
 
@@ -35,7 +36,8 @@ static int mdb_entry_partsize(struct mdb_info *mdb, MDB_txn *txn, Entry *e,
 	Ecount *eh);
 static int mdb_entry_encode(Operation *op, Entry *e, MDB_val *data,
 	Ecount *ec);
-static Entry *mdb_entry_alloc( Operation *op, int nattrs, int nvals );
+static Entry *mdb_entry_alloc( Operation *op, int nattrs, int nvals,
+	size_t ixlen );
 
 #define ID2VKSZ	(sizeof(ID)+2)
 
@@ -413,7 +415,7 @@ int mdb_id2entry(
 		/* Looking for root entry on an empty-dn suffix? */
 		if ( !id && BER_BVISEMPTY( &op->o_bd->be_nsuffix[0] )) {
 			struct berval gluebv = BER_BVC("glue");
-			Entry *r = mdb_entry_alloc(op, 2, 4);
+			Entry *r = mdb_entry_alloc(op, 2, 4, 0);
 			Attribute *a = r->e_attrs;
 			struct berval *bptr;
 
@@ -505,12 +507,14 @@ int mdb_id2entry_delete(
 static Entry * mdb_entry_alloc(
 	Operation *op,
 	int nattrs,
-	int nvals )
+	int nvals,
+	size_t ixlen )
 {
 	Entry *e = op->o_tmpalloc( sizeof(Entry) +
 		nattrs * sizeof(Attribute) +
-		nvals * sizeof(struct berval), op->o_tmpmemctx );
+		nvals * sizeof(struct berval) + ixlen, op->o_tmpmemctx );
 	BER_BVZERO(&e->e_bv);
+	e->e_attrindex = NULL;
 	e->e_private = e;
 	if (nattrs) {
 		e->e_attrs = (Attribute *)(e+1);
@@ -837,16 +841,18 @@ int mdb_txn( Operation *op, int txnop, OpExtra **ptr )
 		if ( !rc ) {
 			moi = *moip;
 			moi->moi_flag |= MOI_KEEPER;
+			moi->moi_numads = mdb->mi_numads;
 		}
 		return rc;
 	case SLAP_TXN_COMMIT:
 		rc = mdb_txn_commit( moi->moi_txn );
 		if ( rc )
-			mdb->mi_numads = 0;
+			mdb_ad_unwind( mdb, moi->moi_numads );
 		op->o_tmpfree( moi, op->o_tmpmemctx );
 		return rc;
 	case SLAP_TXN_ABORT:
-		mdb->mi_numads = 0;
+		/* forget the AttributeDescriptions this txn added to ad2id */
+		mdb_ad_unwind( mdb, moi->moi_numads );
 		mdb_txn_abort( moi->moi_txn );
 		op->o_tmpfree( moi, op->o_tmpmemctx );
 		return 0;
@@ -854,6 +860,13 @@ int mdb_txn( Operation *op, int txnop, OpExtra **ptr )
 	return LDAP_OTHER;
 }
 
+/* A normalized value identical to its value is stored as a reference */
+#define MDB_NVAL_IS_SAME(a, i) \
+	((a)->a_nvals[i].bv_len == (a)->a_vals[i].bv_len && \
+	((a)->a_nvals[i].bv_val == (a)->a_vals[i].bv_val || \
+	!memcmp((a)->a_nvals[i].bv_val, (a)->a_vals[i].bv_val, \
+		(a)->a_vals[i].bv_len)))
+
 /* Count up the sizes of the components of an entry */
 static int mdb_entry_partsize(struct mdb_info *mdb, MDB_txn *txn, Entry *e,
 	Ecount *eh)
@@ -864,6 +877,7 @@ static int mdb_entry_partsize(struct mdb_info *mdb, MDB_txn *txn, Entry *e,
 	unsigned hi;
 
 	eh->multi = NULL;
+	eh->nvsame = mdb->mi_dedupnvals;
 	len = 4*sizeof(int);	/* nattrs, nvals, ocflags, offset */
 	dlen = len;
 	for (a=e->e_attrs; a; a=a->a_next) {
@@ -903,9 +917,12 @@ static int mdb_entry_partsize(struct mdb_info *mdb, MDB_txn *txn, Entry *e,
 				doff += a->a_numvals;
 			for (i=0; i<a->a_numvals; i++) {
 				int alen = a->a_nvals[i].bv_len + 1 + sizeof(int);
-				len += alen;
-				if (!(a->a_flags & SLAP_ATTR_BIG_MULTI))
+				if (!(a->a_flags & SLAP_ATTR_BIG_MULTI)) {
+					if (eh->nvsame && MDB_NVAL_IS_SAME(a, i))
+						alen = sizeof(int);
 					dlen += alen;
+				}
+				len += alen;
 			}
 		}
 	}
@@ -928,6 +945,12 @@ static int mdb_entry_partsize(struct mdb_info *mdb, MDB_txn *txn, Entry *e,
 #define MDB_AT_NVALS	(1U<<(sizeof(unsigned int)*CHAR_BIT-1))
 	/* this attribute has normalized values */
 
+#define MDB_NVAL_SAME	(1U<<(sizeof(unsigned int)*CHAR_BIT-1))
+	/* this normalized value is the same as the value */
+
+#define MDB_ENTRY_NVSAME	(1U<<(sizeof(unsigned int)*CHAR_BIT-1))
+	/* in the ocflags word: the entry may use MDB_NVAL_SAME */
+
 /* Flatten an Entry into a buffer. The buffer starts with the count of the
  * number of attributes in the entry, the total number of values in the
  * entry, and the e_ocflags. It then contains a list of integers for each
@@ -946,6 +969,13 @@ static int mdb_entry_partsize(struct mdb_info *mdb, MDB_txn *txn, Entry *e,
  * their lengths come next. This continues for each attribute. After all
  * of the lengths for the last attribute, the actual values are copied,
  * with a NUL terminator after each value.
+ *
+ * If the MDB_ENTRY_NVSAME bit of the e_ocflags word is set, a normalized
+ * value that is identical to its value is stored as just MDB_NVAL_SAME
+ * in place of its length, and its bytes are not copied again. Entries
+ * are only written this way when dedupnvals is on; releases that predate
+ * it misread them, see slapd-mdb(5). Entries without the bit are always
+ * decoded as before.
  * The buffer is padded to the sizeof(ID). The entire buffer size is
  * precomputed so that a single malloc can be performed.
  */
@@ -967,7 +997,8 @@ static int mdb_entry_encode(Operation *op, Entry *e, MDB_val *data, Ecount *eh)
 	lp = (unsigned int *)data->mv_data;
 	*lp++ = eh->nattrs;
 	*lp++ = eh->nvals;
-	*lp++ = (unsigned int)e->e_ocflags;
+	*lp++ = (unsigned int)e->e_ocflags |
+		(eh->nvsame ? MDB_ENTRY_NVSAME : 0);
 	*lp++ = eh->offset;
 	ptr = (unsigned char *)(lp + eh->offset);
 
@@ -999,6 +1030,10 @@ static int mdb_entry_encode(Operation *op, Entry *e, MDB_val *data, Ecount *eh)
 				}
 				if (a->a_nvals != a->a_vals) {
 					for (i=0; i<a->a_numvals; i++) {
+						if (eh->nvsame && MDB_NVAL_IS_SAME(a, i)) {
+							*lp++ = MDB_NVAL_SAME;
+							continue;
+						}
 						*lp++ = a->a_nvals[i].bv_len;
 						memcpy(ptr, a->a_nvals[i].bv_val,
 							a->a_nvals[i].bv_len);
@@ -1026,7 +1061,8 @@ static int mdb_entry_encode(Operation *op, Entry *e, MDB_val *data, Ecount *eh)
 int mdb_entry_decode(Operation *op, MDB_txn *txn, MDB_val *data, ID id, Entry **e)
 {
 	struct mdb_info *mdb = (struct mdb_info *) op->o_bd->be_private;
-	int i, j, nattrs, nvals;
+	int i, j, nattrs, nvals, ixattrs = 0, nvsame = 0;
+	size_t ixlen = 0;
 	int rc;
 	Attribute *a;
 	Entry *x;
@@ -1041,8 +1077,20 @@ int mdb_entry_decode(Operation *op, MDB_txn *txn, MDB_val *data, ID id, Entry **
 
 	nattrs = *lp++;
 	nvals = *lp++;
-	x = mdb_entry_alloc(op, nattrs, nvals);
-	x->e_ocflags = *lp++;
+	/* not for tools, which may edit the entry in place */
+	if ( mdb->mi_attrtable && (unsigned)nattrs >= mdb->mi_attrtable &&
+		( slapMode & SLAP_SERVER_MODE ))
+	{
+		ixattrs = nattrs;
+		ixlen = entry_attr_index_size( nattrs );
+	}
+	x = mdb_entry_alloc(op, nattrs, nvals, ixlen);
+	i = *lp++;
+	if (i & MDB_ENTRY_NVSAME) {
+		i ^= MDB_ENTRY_NVSAME;
+		nvsame = 1;
+	}
+	x->e_ocflags = i;
 	if (!nvals) {
 		goto done;
 	}
@@ -1108,6 +1156,11 @@ int mdb_entry_decode(Operation *op, MDB_txn *txn, MDB_val *data, ID id, Entry **
 			if (have_nval) {
 				a->a_nvals = bptr;
 				for (i=0; i<a->a_numvals; i++) {
+					if (nvsame && *lp == MDB_NVAL_SAME) {
+						lp++;
+						*bptr++ = a->a_vals[i];
+						continue;
+					}
 					bptr->bv_len = *lp++;
 					bptr->bv_val = (char *)ptr;
 					ptr += bptr->bv_len+1;
@@ -1139,6 +1192,11 @@ int mdb_entry_decode(Operation *op, MDB_txn *txn, MDB_val *data, ID id, Entry **
 		a = a->a_next;
 	}
 	a[-1].a_next = NULL;
+	if ( ixattrs ) {
+		/* the table goes after the values, see mdb_entry_alloc */
+		entry_attr_index( x, (struct berval *)( x->e_attrs + ixattrs ) + nvals,
+			ixattrs );
+	}
 done:
 	Debug(LDAP_DEBUG_TRACE, "<= mdb_entry_decode\n" );
 	*e = x;
@@ -432,18 +432,15 @@ mdb_idl_insert_keys(
 
 	assert( id != NOID );
 
-#ifndef MISALIGNED_OK
-	if (keys[0].bv_len & ALIGNER)
-		kbuf[1] = 0;
-#endif
 	for ( k=0; keys[k].bv_val; k++ ) {
 	/* Fetch the first data item for this key, to see if it
 	 * exists and if it's a range.
 	 */
 #ifndef MISALIGNED_OK
-	if (keys[k].bv_len & ALIGNER) {
+	if ((keys[k].bv_len & ALIGNER) && keys[k].bv_len < sizeof(kbuf)) {
 		key.mv_size = sizeof(kbuf);
 		key.mv_data = kbuf;
+		memset(kbuf, 0, sizeof(kbuf));
 		memcpy(key.mv_data, keys[k].bv_val, keys[k].bv_len);
 	} else
 #endif
@@ -590,18 +587,15 @@ mdb_idl_delete_keys(
 	}
 	assert( id != NOID );
 
-#ifndef MISALIGNED_OK
-	if (keys[0].bv_len & ALIGNER)
-		kbuf[1] = 0;
-#endif
 	for ( k=0; keys[k].bv_val; k++) {
 	/* Fetch the first data item for this key, to see if it
 	 * exists and if it's a range.
 	 */
 #ifndef MISALIGNED_OK
-	if (keys[k].bv_len & ALIGNER) {
+	if ((keys[k].bv_len & ALIGNER) && keys[k].bv_len < sizeof(kbuf)) {
 		key.mv_size = sizeof(kbuf);
 		key.mv_data = kbuf;
+		memset(kbuf, 0, sizeof(kbuf));
 		memcpy(key.mv_data, keys[k].bv_val, keys[k].bv_len);
 	} else
 #endif
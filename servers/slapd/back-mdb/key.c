@@ -46,10 +46,10 @@ mdb_key_read(
 	Debug( LDAP_DEBUG_TRACE, "=> key_read\n" );
 
 #ifndef MISALIGNED_OK
-	if (k->bv_len & ALIGNER) {
+	if ((k->bv_len & ALIGNER) && k->bv_len < sizeof(kbuf)) {
 		key.mv_size = sizeof(kbuf);
 		key.mv_data = kbuf;
-		kbuf[1] = 0;
+		memset(kbuf, 0, sizeof(kbuf));
 		memcpy(kbuf, k->bv_val, k->bv_len);
 	} else
 #endif
@@ -70,3 +70,66 @@ mdb_key_read(
 
 	return rc;
 }
+
+/* count the IDs stored under a key; a range counts as its span */
+int
+mdb_key_count(
+	Backend	*be,
+	MDB_txn *txn,
+	MDB_dbi dbi,
+	struct berval *k,
+	ID *countp
+)
+{
+	int rc;
+	MDB_val key, data;
+	MDB_cursor *cursor;
+	ID lo, hi;
+	size_t count;
+#ifndef MISALIGNED_OK
+	int kbuf[2];
+#endif
+
+#ifndef MISALIGNED_OK
+	if ((k->bv_len & ALIGNER) && k->bv_len < sizeof(kbuf)) {
+		key.mv_size = sizeof(kbuf);
+		key.mv_data = kbuf;
+		memset(kbuf, 0, sizeof(kbuf));
+		memcpy(kbuf, k->bv_val, k->bv_len);
+	} else
+#endif
+	{
+		key.mv_size = k->bv_len;
+		key.mv_data = k->bv_val;
+	}
+
+	rc = mdb_cursor_open( txn, dbi, &cursor );
+	if ( rc ) {
+		return rc;
+	}
+
+	rc = mdb_cursor_get( cursor, &key, &data, MDB_SET );
+	if ( rc == 0 ) {
+		memcpy( &lo, data.mv_data, sizeof(ID) );
+		if ( lo == 0 ) {
+			/* range: 0, lo, hi */
+			rc = mdb_cursor_get( cursor, &key, &data, MDB_NEXT_DUP );
+			if ( rc == 0 ) {
+				memcpy( &lo, data.mv_data, sizeof(ID) );
+				rc = mdb_cursor_get( cursor, &key, &data, MDB_NEXT_DUP );
+			}
+			if ( rc == 0 ) {
+				memcpy( &hi, data.mv_data, sizeof(ID) );
+				*countp = hi - lo + 1;
+			}
+		} else {
+			rc = mdb_cursor_count( cursor, &count );
+			if ( rc == 0 ) {
+				*countp = count;
+			}
+		}
+	}
+
+	mdb_cursor_close( cursor );
+	return rc;
+}
@@ -711,6 +711,7 @@ mdb_modify( Operation *op, SlapReply *rs )
 
 	/* Modify the entry */
 	dummy = *e;
+	dummy.e_attrindex = NULL;
 	rs->sr_err = mdb_modify_internal( op, txn, op->orm_modlist,
 		&dummy, &rs->sr_text, textbuf, textlen );
 
@@ -438,6 +438,7 @@ mdb_modrdn( Operation	*op, SlapReply *rs )
 	dummy.e_name = new_dn;
 	dummy.e_nname = new_ndn;
 	dummy.e_attrs = NULL;
+	dummy.e_attrindex = NULL;
 
 	/* add new DN */
 	rs->sr_err = mdb_dn2id_add( op, mc, mc, np ? np->e_id : p->e_id,
@@ -428,6 +428,7 @@ mdb_search( Operation *op, SlapReply *rs )
 	Entry		*e = NULL, *base = NULL;
 	Entry		*matched = NULL;
 	AttributeName	*attrs;
+	FilterProg	*fprog = NULL;
 	slap_mask_t	mask;
 	time_t		stoptime;
 	int		manageDSAit;
@@ -1083,7 +1084,13 @@ notfound:
 		}
 
 		/* if it matches the filter and scope, send it */
-		rs->sr_err = test_filter( op, e, op->oq_search.rs_filter );
+		if ( slap_filter_compile ) {
+			if ( fprog == NULL )
+				fprog = filter_compile( op, op->oq_search.rs_filter );
+			rs->sr_err = filter_prog_test( op, e, fprog );
+		} else {
+			rs->sr_err = test_filter( op, e, op->oq_search.rs_filter );
+		}
 
 		if ( rs->sr_err == LDAP_COMPARE_TRUE ) {
 			/* check size limit */
@@ -1241,6 +1248,8 @@ done:
 	}
 	if (base)
 		mdb_entry_return( op, base );
+	if ( fprog )
+		filter_prog_free( op, fprog );
 	scope_chunk_ret( op, scopes );
 	if ( candidates != c0 ) {
 		ch_free( candidates );
@@ -210,8 +210,13 @@ static struct monitor_subsys_t known_monitor_subsys[] = {
 		BER_BVNULL, BER_BVNULL, BER_BVNULL,
 		{ BER_BVC( "This subsystem contains information about TLS." ),
 			BER_BVNULL },
+#ifdef HAVE_TLS
+		MONITOR_F_PERSISTENT_CH,
+		monitor_subsys_tls_init,
+#else
 		MONITOR_F_NONE,
 		NULL,   /* init */
+#endif
 		NULL,	/* destroy */
 		NULL,   /* update */
 		NULL,   /* create */
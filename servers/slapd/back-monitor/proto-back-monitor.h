@@ -310,6 +310,14 @@ extern int monitor_subsys_time_init LDAP_P((
 	BackendDB		*be,
 	monitor_subsys_t	*ms ));
 
+/*
+ * TLS
+ */
+extern int
+monitor_subsys_tls_init LDAP_P((
+	BackendDB		*be,
+	monitor_subsys_t	*ms ));
+
 /*
  * waiters
  */
@@ -43,6 +43,19 @@ enum {
 	MONITOR_SENT_PDU,
 	MONITOR_SENT_ENTRIES,
 	MONITOR_SENT_REFERRALS,
+	MONITOR_SENT_ACL_EVALS,
+	MONITOR_SENT_ACL_RULES,
+	MONITOR_SENT_ACL_SKIPPED,
+	MONITOR_SENT_OP_ALLOCATED,
+	MONITOR_SENT_OP_REUSED,
+	MONITOR_SENT_OP_IDLE,
+	MONITOR_SENT_GC_HITS,
+	MONITOR_SENT_GC_MISSES,
+	MONITOR_SENT_GC_INVALIDATED,
+	MONITOR_SENT_GC_ENTRIES,
+	MONITOR_SENT_DN_HITS,
+	MONITOR_SENT_DN_MISSES,
+	MONITOR_SENT_DN_ENTRIES,
 
 	MONITOR_SENT_LAST
 };
@@ -55,6 +68,19 @@ struct monitor_sent_t {
 	{ BER_BVC("cn=PDU"),		BER_BVNULL },
 	{ BER_BVC("cn=Entries"),	BER_BVNULL },
 	{ BER_BVC("cn=Referrals"),	BER_BVNULL },
+	{ BER_BVC("cn=ACL Evaluations"),	BER_BVNULL },
+	{ BER_BVC("cn=ACL Rules Tested"),	BER_BVNULL },
+	{ BER_BVC("cn=ACL Rules Skipped"),	BER_BVNULL },
+	{ BER_BVC("cn=Op Pool Allocated"),	BER_BVNULL },
+	{ BER_BVC("cn=Op Pool Reused"),	BER_BVNULL },
+	{ BER_BVC("cn=Op Pool Idle"),	BER_BVNULL },
+	{ BER_BVC("cn=Group Cache Hits"),	BER_BVNULL },
+	{ BER_BVC("cn=Group Cache Misses"),	BER_BVNULL },
+	{ BER_BVC("cn=Group Cache Invalidated"),	BER_BVNULL },
+	{ BER_BVC("cn=Group Cache Entries"),	BER_BVNULL },
+	{ BER_BVC("cn=DN Cache Hits"),	BER_BVNULL },
+	{ BER_BVC("cn=DN Cache Misses"),	BER_BVNULL },
+	{ BER_BVC("cn=DN Cache Entries"),	BER_BVNULL },
 	{ BER_BVNULL,			BER_BVNULL }
 };
 
@@ -184,6 +210,66 @@ monitor_subsys_sent_update(
 		return SLAP_CB_CONTINUE;
 	}
 
+	if ( i >= MONITOR_SENT_DN_HITS ) {
+		slap_dn_cache_stats_t ds;
+
+		dn_cache_stats( &ds );
+		ldap_pvt_mp_init( n );
+		switch ( i ) {
+		case MONITOR_SENT_DN_HITS:
+			ldap_pvt_mp_add_ulong( n, ds.ds_hits );
+			break;
+		case MONITOR_SENT_DN_MISSES:
+			ldap_pvt_mp_add_ulong( n, ds.ds_misses );
+			break;
+		default:
+			ldap_pvt_mp_add_ulong( n, ds.ds_entries );
+			break;
+		}
+		goto done;
+	}
+
+	if ( i >= MONITOR_SENT_GC_HITS ) {
+		slap_group_cache_stats_t gs;
+
+		slap_group_cache_stats( &gs );
+		ldap_pvt_mp_init( n );
+		switch ( i ) {
+		case MONITOR_SENT_GC_HITS:
+			ldap_pvt_mp_add_ulong( n, gs.gs_hits );
+			break;
+		case MONITOR_SENT_GC_MISSES:
+			ldap_pvt_mp_add_ulong( n, gs.gs_misses );
+			break;
+		case MONITOR_SENT_GC_INVALIDATED:
+			ldap_pvt_mp_add_ulong( n, gs.gs_invalidated );
+			break;
+		default:
+			ldap_pvt_mp_add_ulong( n, gs.gs_entries );
+			break;
+		}
+		goto done;
+	}
+
+	if ( i >= MONITOR_SENT_OP_ALLOCATED ) {
+		slap_op_pool_stats_t ps;
+
+		slap_op_pool_stats( &ps );
+		ldap_pvt_mp_init( n );
+		switch ( i ) {
+		case MONITOR_SENT_OP_ALLOCATED:
+			ldap_pvt_mp_add_ulong( n, ps.ps_allocated );
+			break;
+		case MONITOR_SENT_OP_REUSED:
+			ldap_pvt_mp_add_ulong( n, ps.ps_reused );
+			break;
+		default:
+			ldap_pvt_mp_add_ulong( n, ps.ps_pooled );
+			break;
+		}
+		goto done;
+	}
+
 	ldap_pvt_thread_mutex_lock(&slap_counters.sc_mutex);
 	switch ( i ) {
 	case MONITOR_SENT_ENTRIES:
@@ -222,11 +308,39 @@ monitor_subsys_sent_update(
 		}
 		break;
 
+	case MONITOR_SENT_ACL_EVALS:
+		ldap_pvt_mp_init_set( n, slap_counters.sc_acl_evals );
+		for ( sc = slap_counters.sc_next; sc; sc = sc->sc_next ) {
+			ldap_pvt_thread_mutex_lock( &sc->sc_mutex );
+			ldap_pvt_mp_add( n, sc->sc_acl_evals );
+			ldap_pvt_thread_mutex_unlock( &sc->sc_mutex );
+		}
+		break;
+
+	case MONITOR_SENT_ACL_RULES:
+		ldap_pvt_mp_init_set( n, slap_counters.sc_acl_rules );
+		for ( sc = slap_counters.sc_next; sc; sc = sc->sc_next ) {
+			ldap_pvt_thread_mutex_lock( &sc->sc_mutex );
+			ldap_pvt_mp_add( n, sc->sc_acl_rules );
+			ldap_pvt_thread_mutex_unlock( &sc->sc_mutex );
+		}
+		break;
+
+	case MONITOR_SENT_ACL_SKIPPED:
+		ldap_pvt_mp_init_set( n, slap_counters.sc_acl_skipped );
+		for ( sc = slap_counters.sc_next; sc; sc = sc->sc_next ) {
+			ldap_pvt_thread_mutex_lock( &sc->sc_mutex );
+			ldap_pvt_mp_add( n, sc->sc_acl_skipped );
+			ldap_pvt_thread_mutex_unlock( &sc->sc_mutex );
+		}
+		break;
+
 	default:
 		assert(0);
 	}
 	ldap_pvt_thread_mutex_unlock(&slap_counters.sc_mutex);
-	
+
+done:
 	a = attr_find( e->e_attrs, mi->mi_ad_monitorCounter );
 	assert( a != NULL );
 
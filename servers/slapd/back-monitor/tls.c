@@ -0,0 +1,231 @@
+/* tls.c - deal with TLS subsystem */
+/* $OpenLDAP$ */
+/* This work is part of OpenLDAP Software <http://www.openldap.org/>.
+ *
+ * Copyright 2001-2022 The OpenLDAP Foundation.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted only as authorized by the OpenLDAP
+ * Public License.
+ *
+ * A copy of this license is available in file LICENSE in the
+ * top-level directory of the distribution or, alternatively, at
+ * <http://www.OpenLDAP.org/license.html>.
+ */
+
+#include "portable.h"
+
+#include <stdio.h>
+#include <ac/string.h>
+
+#include "slap.h"
+#include "lutil.h"
+#include "back-monitor.h"
+
+#ifdef HAVE_TLS
+
+static int
+monitor_subsys_tls_destroy(
+	BackendDB		*be,
+	monitor_subsys_t	*ms );
+
+static int
+monitor_subsys_tls_update(
+	Operation		*op,
+	SlapReply		*rs,
+	Entry                   *e );
+
+enum {
+	MONITOR_TLS_FULL = 0,
+	MONITOR_TLS_RESUMED,
+	MONITOR_TLS_CACHE_HITS,
+	MONITOR_TLS_CACHE_MISSES,
+	MONITOR_TLS_CACHE_ENTRIES,
+
+	MONITOR_TLS_LAST
+};
+
+static struct monitor_tls_t {
+	struct berval	rdn;
+	struct berval	nrdn;
+} monitor_tls[] = {
+	{ BER_BVC("cn=Full Handshakes"),	BER_BVNULL },
+	{ BER_BVC("cn=Resumed Handshakes"),	BER_BVNULL },
+	{ BER_BVC("cn=Session Cache Hits"),	BER_BVNULL },
+	{ BER_BVC("cn=Session Cache Misses"),	BER_BVNULL },
+	{ BER_BVC("cn=Session Cache Entries"),	BER_BVNULL },
+	{ BER_BVNULL,				BER_BVNULL }
+};
+
+int
+monitor_subsys_tls_init(
+	BackendDB		*be,
+	monitor_subsys_t	*ms )
+{
+	monitor_info_t	*mi;
+
+	Entry		**ep, *e_tls;
+	monitor_entry_t	*mp;
+	int			i;
+
+	assert( be != NULL );
+
+	ms->mss_destroy = monitor_subsys_tls_destroy;
+	ms->mss_update = monitor_subsys_tls_update;
+
+	mi = ( monitor_info_t * )be->be_private;
+
+	if ( monitor_cache_get( mi, &ms->mss_ndn, &e_tls ) ) {
+		Debug( LDAP_DEBUG_ANY,
+			"monitor_subsys_tls_init: "
+			"unable to get entry \"%s\"\n",
+			ms->mss_ndn.bv_val );
+		return( -1 );
+	}
+
+	mp = ( monitor_entry_t * )e_tls->e_private;
+	mp->mp_children = NULL;
+	ep = &mp->mp_children;
+
+	for ( i = 0; i < MONITOR_TLS_LAST; i++ ) {
+		struct berval		nrdn, bv;
+		Entry			*e;
+
+		e = monitor_entry_stub( &ms->mss_dn, &ms->mss_ndn, &monitor_tls[i].rdn,
+			mi->mi_oc_monitorCounterObject, NULL, NULL );
+		if ( e == NULL ) {
+			Debug( LDAP_DEBUG_ANY,
+				"monitor_subsys_tls_init: "
+				"unable to create entry \"%s,%s\"\n",
+				monitor_tls[ i ].rdn.bv_val,
+				ms->mss_ndn.bv_val );
+			return( -1 );
+		}
+
+		/* steal normalized RDN */
+		dnRdn( &e->e_nname, &nrdn );
+		ber_dupbv( &monitor_tls[ i ].nrdn, &nrdn );
+
+		BER_BVSTR( &bv, "0" );
+		attr_merge_one( e, mi->mi_ad_monitorCounter, &bv, NULL );
+
+		mp = monitor_entrypriv_create();
+		if ( mp == NULL ) {
+			return -1;
+		}
+		e->e_private = ( void * )mp;
+		mp->mp_info = ms;
+		mp->mp_flags = ms->mss_flags \
+			| MONITOR_F_SUB | MONITOR_F_PERSISTENT;
+
+		if ( monitor_cache_add( mi, e ) ) {
+			Debug( LDAP_DEBUG_ANY,
+				"monitor_subsys_tls_init: "
+				"unable to add entry \"%s,%s\"\n",
+				monitor_tls[ i ].rdn.bv_val,
+				ms->mss_ndn.bv_val );
+			return( -1 );
+		}
+
+		*ep = e;
+		ep = &mp->mp_next;
+	}
+
+	monitor_cache_release( mi, e_tls );
+
+	return( 0 );
+}
+
+static int
+monitor_subsys_tls_destroy(
+	BackendDB		*be,
+	monitor_subsys_t	*ms )
+{
+	int		i;
+
+	for ( i = 0; i < MONITOR_TLS_LAST; i++ ) {
+		ber_memfree_x( monitor_tls[ i ].nrdn.bv_val, NULL );
+	}
+
+	return 0;
+}
+
+static int
+monitor_subsys_tls_update(
+	Operation		*op,
+	SlapReply		*rs,
+	Entry                   *e )
+{
+	monitor_info_t *mi = (monitor_info_t *)op->o_bd->be_private;
+	ldap_pvt_tls_stats	ts;
+
+	int		i;
+	struct berval	nrdn;
+
+	Attribute	*a;
+	char 		buf[LDAP_PVT_INTTYPE_CHARS(unsigned long)];
+	unsigned long	num = 0;
+	ber_len_t	len;
+
+	assert( mi != NULL );
+	assert( e != NULL );
+
+	dnRdn( &e->e_nname, &nrdn );
+
+	for ( i = 0; !BER_BVISNULL( &monitor_tls[ i ].nrdn ); i++ ) {
+		if ( dn_match( &nrdn, &monitor_tls[ i ].nrdn ) ) {
+			break;
+		}
+	}
+
+	if ( i == MONITOR_TLS_LAST ) {
+		return SLAP_CB_CONTINUE;
+	}
+
+	ldap_pvt_tls_get_stats( &ts );
+
+	switch ( i ) {
+	case MONITOR_TLS_FULL:
+		num = ts.ts_full;
+		break;
+
+	case MONITOR_TLS_RESUMED:
+		num = ts.ts_resumed;
+		break;
+
+	case MONITOR_TLS_CACHE_HITS:
+		num = ts.ts_cache_hits;
+		break;
+
+	case MONITOR_TLS_CACHE_MISSES:
+		num = ts.ts_cache_misses;
+		break;
+
+	case MONITOR_TLS_CACHE_ENTRIES:
+		num = ts.ts_cache_entries;
+		break;
+
+	default:
+		assert( 0 );
+	}
+
+	snprintf( buf, sizeof( buf ), "%lu", num );
+
+	a = attr_find( e->e_attrs, mi->mi_ad_monitorCounter );
+	assert( a != NULL );
+	len = strlen( buf );
+	if ( len > a->a_vals[ 0 ].bv_len ) {
+		a->a_vals[ 0 ].bv_val = ber_memrealloc( a->a_vals[ 0 ].bv_val, len + 1 );
+		if ( BER_BVISNULL( &a->a_vals[ 0 ] ) ) {
+			BER_BVZERO( &a->a_vals[ 0 ] );
+			return SLAP_CB_CONTINUE;
+		}
+	}
+	AC_MEMCPY( a->a_vals[ 0 ].bv_val, buf, len + 1 );
+	a->a_vals[ 0 ].bv_len = len;
+
+	return SLAP_CB_CONTINUE;
+}
+
+#endif /* HAVE_TLS */
@@ -44,6 +44,7 @@ sock_back_compare(
 	e.e_name = op->o_req_dn;
 	e.e_nname = op->o_req_ndn;
 	e.e_attrs = NULL;
+	e.e_attrindex = NULL;
 	e.e_ocflags = 0;
 	e.e_bv.bv_len = 0;
 	e.e_bv.bv_val = NULL;
@@ -1441,6 +1441,335 @@ be_entry_get_rw(
 	return LDAP_UNWILLING_TO_PERFORM;
 }
 
+/*
+ * Server-wide cache of static group membership, keyed by member DN.
+ * It complements the per-operation o_groups list; results are dropped
+ * when the group entry (or one of its ancestors, for modrdn) is written,
+ * see slap_group_cache_invalidate(), and all of them are dropped when
+ * a backend transaction commits, see slap_group_cache_flush().  Dynamic
+ * (labeledURI) groups are not cached since their result depends on the
+ * member entry.
+ */
+typedef struct gc_member gc_member;
+
+typedef struct gc_group {
+	struct berval	gg_ndn;
+	gc_member	*gg_members;
+} gc_group;
+
+struct gc_member {
+	struct berval	gm_ndn;
+	gc_group	*gm_group;
+	BackendDB	*gm_be;
+	ObjectClass	*gm_oc;
+	AttributeDescription	*gm_at;
+	int		gm_res;
+	time_t		gm_time;
+	gc_member	*gm_gnext, **gm_gprev;	/* results for the same group */
+	gc_member	*gm_lnext, *gm_lprev;	/* LRU, most recent first */
+};
+
+static ldap_pvt_thread_mutex_t	gc_mutex;
+static Avlnode		*gc_groups, *gc_members;
+static gc_member	*gc_lru_head, *gc_lru_tail;
+static unsigned long	gc_gen;
+static slap_group_cache_stats_t	gc_stats;
+
+static int
+gc_ndn_cmp( struct berval *l, struct berval *r )
+{
+	if ( l->bv_len != r->bv_len )
+		return l->bv_len < r->bv_len ? -1 : 1;
+	return memcmp( l->bv_val, r->bv_val, l->bv_len );
+}
+
+static int
+gc_group_cmp( const void *v1, const void *v2 )
+{
+	const gc_group *g1 = v1, *g2 = v2;
+
+	return gc_ndn_cmp( (struct berval *)&g1->gg_ndn,
+		(struct berval *)&g2->gg_ndn );
+}
+
+#define GC_PTRCMP(a, b) \
+	if ( (a) != (b) ) return (char *)(a) < (char *)(b) ? -1 : 1
+
+static int
+gc_member_cmp( const void *v1, const void *v2 )
+{
+	const gc_member *m1 = v1, *m2 = v2;
+	int rc;
+
+	rc = gc_ndn_cmp( (struct berval *)&m1->gm_ndn,
+		(struct berval *)&m2->gm_ndn );
+	if ( rc )
+		return rc;
+	GC_PTRCMP( m1->gm_group, m2->gm_group );
+	GC_PTRCMP( m1->gm_be, m2->gm_be );
+	GC_PTRCMP( m1->gm_oc, m2->gm_oc );
+	GC_PTRCMP( m1->gm_at, m2->gm_at );
+	return 0;
+}
+
+static void
+gc_lru_unlink( gc_member *m )
+{
+	if ( m->gm_lprev )
+		m->gm_lprev->gm_lnext = m->gm_lnext;
+	else
+		gc_lru_head = m->gm_lnext;
+	if ( m->gm_lnext )
+		m->gm_lnext->gm_lprev = m->gm_lprev;
+	else
+		gc_lru_tail = m->gm_lprev;
+}
+
+static void
+gc_lru_push( gc_member *m )
+{
+	m->gm_lprev = NULL;
+	m->gm_lnext = gc_lru_head;
+	if ( gc_lru_head )
+		gc_lru_head->gm_lprev = m;
+	else
+		gc_lru_tail = m;
+	gc_lru_head = m;
+}
+
+/* must be called with gc_mutex held */
+static void
+gc_member_free( gc_member *m )
+{
+	gc_group *g = m->gm_group;
+
+	ldap_avl_delete( &gc_members, m, gc_member_cmp );
+	gc_lru_unlink( m );
+	*m->gm_gprev = m->gm_gnext;
+	if ( m->gm_gnext )
+		m->gm_gnext->gm_gprev = m->gm_gprev;
+	ch_free( m );
+	gc_stats.gs_entries--;
+
+	if ( g->gg_members == NULL ) {
+		ldap_avl_delete( &gc_groups, g, gc_group_cmp );
+		ch_free( g );
+	}
+}
+
+/* must be called with gc_mutex held */
+static void
+gc_group_drop( gc_group *g )
+{
+	/* the last member frees the group */
+	while ( g->gg_members ) {
+		gc_stats.gs_invalidated++;
+		gc_member_free( g->gg_members );
+	}
+}
+
+static int
+gc_group_drop_subtree( void *v1, void *v2 )
+{
+	gc_group *g = v1;
+	struct berval *ndn = v2;
+
+	if ( dnIsSuffix( &g->gg_ndn, ndn ) )
+		gc_group_drop( g );
+
+	return 0;
+}
+
+static gc_member *
+gc_find( BackendDB *be, struct berval *gr_ndn, struct berval *op_ndn,
+	ObjectClass *group_oc, AttributeDescription *group_at )
+{
+	gc_group gtmp, *g;
+	gc_member mtmp;
+
+	gtmp.gg_ndn = *gr_ndn;
+	g = ldap_avl_find( gc_groups, &gtmp, gc_group_cmp );
+	if ( g == NULL )
+		return NULL;
+
+	mtmp.gm_ndn = *op_ndn;
+	mtmp.gm_group = g;
+	mtmp.gm_be = be;
+	mtmp.gm_oc = group_oc;
+	mtmp.gm_at = group_at;
+	return ldap_avl_find( gc_members, &mtmp, gc_member_cmp );
+}
+
+void
+slap_group_cache_init( void )
+{
+	ldap_pvt_thread_mutex_init( &gc_mutex );
+}
+
+void
+slap_group_cache_destroy( void )
+{
+	while ( gc_lru_head )
+		gc_member_free( gc_lru_head );
+	ldap_pvt_thread_mutex_destroy( &gc_mutex );
+}
+
+void
+slap_group_cache_stats( slap_group_cache_stats_t *gs )
+{
+	ldap_pvt_thread_mutex_lock( &gc_mutex );
+	*gs = gc_stats;
+	ldap_pvt_thread_mutex_unlock( &gc_mutex );
+}
+
+/*
+ * The generation is taken when an operation starts, before the backend
+ * can open a read transaction for it.  A result read through a snapshot
+ * that predates a write therefore always carries an older generation
+ * than the one that write's invalidation produced, and gc_put() drops it.
+ */
+unsigned long
+slap_group_cache_gen( void )
+{
+	unsigned long gen;
+
+	ldap_pvt_thread_mutex_lock( &gc_mutex );
+	gen = gc_gen;
+	ldap_pvt_thread_mutex_unlock( &gc_mutex );
+
+	return gen;
+}
+
+/* Look up a cached result, dropping it if it has aged out */
+static int
+gc_get( BackendDB *be, struct berval *gr_ndn, struct berval *op_ndn,
+	ObjectClass *group_oc, AttributeDescription *group_at, int *resp )
+{
+	gc_member *m;
+	int rc = -1;
+
+	ldap_pvt_thread_mutex_lock( &gc_mutex );
+	m = gc_find( be, gr_ndn, op_ndn, group_oc, group_at );
+	if ( m && slap_group_cache_ttl > 0 &&
+		slap_get_time() - m->gm_time >= slap_group_cache_ttl )
+	{
+		gc_member_free( m );
+		m = NULL;
+	}
+	if ( m ) {
+		gc_lru_unlink( m );
+		gc_lru_push( m );
+		*resp = m->gm_res;
+		gc_stats.gs_hits++;
+		rc = 0;
+	} else {
+		gc_stats.gs_misses++;
+	}
+	ldap_pvt_thread_mutex_unlock( &gc_mutex );
+
+	return rc;
+}
+
+static void
+gc_put( BackendDB *be, struct berval *gr_ndn, struct berval *op_ndn,
+	ObjectClass *group_oc, AttributeDescription *group_at,
+	int res, unsigned long gen )
+{
+	gc_group gtmp, *g;
+	gc_member *m;
+
+	ldap_pvt_thread_mutex_lock( &gc_mutex );
+	/* a write may have happened since the op's snapshot was taken */
+	if ( gen != gc_gen || slap_group_cache_max <= 0 ||
+		gc_find( be, gr_ndn, op_ndn, group_oc, group_at ) )
+	{
+		goto done;
+	}
+
+	gtmp.gg_ndn = *gr_ndn;
+	g = ldap_avl_find( gc_groups, &gtmp, gc_group_cmp );
+	if ( g == NULL ) {
+		g = ch_malloc( sizeof( gc_group ) + gr_ndn->bv_len + 1 );
+		g->gg_ndn.bv_len = gr_ndn->bv_len;
+		g->gg_ndn.bv_val = (char *)( g + 1 );
+		AC_MEMCPY( g->gg_ndn.bv_val, gr_ndn->bv_val, gr_ndn->bv_len + 1 );
+		g->gg_members = NULL;
+		ldap_avl_insert( &gc_groups, g, gc_group_cmp, ldap_avl_dup_error );
+	}
+
+	m = ch_malloc( sizeof( gc_member ) + op_ndn->bv_len + 1 );
+	m->gm_ndn.bv_len = op_ndn->bv_len;
+	m->gm_ndn.bv_val = (char *)( m + 1 );
+	AC_MEMCPY( m->gm_ndn.bv_val, op_ndn->bv_val, op_ndn->bv_len + 1 );
+	m->gm_group = g;
+	m->gm_be = be;
+	m->gm_oc = group_oc;
+	m->gm_at = group_at;
+	m->gm_res = res;
+	m->gm_time = slap_get_time();
+	ldap_avl_insert( &gc_members, m, gc_member_cmp, ldap_avl_dup_error );
+
+	m->gm_gprev = &g->gg_members;
+	m->gm_gnext = g->gg_members;
+	if ( m->gm_gnext )
+		m->gm_gnext->gm_gprev = &m->gm_gnext;
+	g->gg_members = m;
+	gc_lru_push( m );
+	gc_stats.gs_entries++;
+
+	while ( gc_stats.gs_entries > slap_group_cache_max )
+		gc_member_free( gc_lru_tail );
+
+done:
+	ldap_pvt_thread_mutex_unlock( &gc_mutex );
+}
+
+/*
+ * Called for each successful write; drops the cached results of any
+ * group stored at ndn, or below it if the subtree may have moved.
+ */
+void
+slap_group_cache_invalidate( struct berval *ndn, int subtree )
+{
+	gc_group gtmp, *g;
+
+	if ( slap_group_cache_max <= 0 && gc_lru_head == NULL )
+		return;
+
+	ldap_pvt_thread_mutex_lock( &gc_mutex );
+	gc_gen++;
+	if ( subtree ) {
+		ldap_avl_apply( gc_groups, gc_group_drop_subtree, ndn, -1,
+			AVL_POSTORDER );
+	} else {
+		gtmp.gg_ndn = *ndn;
+		g = ldap_avl_find( gc_groups, &gtmp, gc_group_cmp );
+		if ( g )
+			gc_group_drop( g );
+	}
+	ldap_pvt_thread_mutex_unlock( &gc_mutex );
+}
+
+/*
+ * Called when a backend transaction commits.  The writes it contains
+ * invalidated the cache when their results were sent, before they were
+ * visible to readers, so anything cached since may be stale.
+ */
+void
+slap_group_cache_flush( void )
+{
+	if ( slap_group_cache_max <= 0 && gc_lru_head == NULL )
+		return;
+
+	ldap_pvt_thread_mutex_lock( &gc_mutex );
+	gc_gen++;
+	while ( gc_lru_head ) {
+		gc_stats.gs_invalidated++;
+		gc_member_free( gc_lru_head );
+	}
+	ldap_pvt_thread_mutex_unlock( &gc_mutex );
+}
+
 int 
 fe_acl_group(
 	Operation *op,
@@ -1453,7 +1782,7 @@ fe_acl_group(
 	Entry *e;
 	void *o_priv = op->o_private, *e_priv = NULL;
 	Attribute *a;
-	int rc;
+	int rc, cache = 0;
 	GroupAssertion *g;
 	Backend *be = op->o_bd;
 	OpExtra		*oex;
@@ -1486,18 +1815,33 @@ fe_acl_group(
 	}
 
 	if ( target && dn_match( &target->e_nname, gr_ndn ) ) {
+		/* not cached, target may be an uncommitted version */
 		e = target;
 		rc = 0;
 
 	} else {
+		if ( slap_group_cache_max > 0 ) {
+			if ( gc_get( op->o_bd, gr_ndn, op_ndn, group_oc, group_at,
+				&rc ) == 0 )
+			{
+				goto done;
+			}
+			cache = 1;
+		}
+
 		op->o_private = NULL;
 		rc = be_entry_get_rw( op, gr_ndn, group_oc, group_at, 0, &e );
 		e_priv = op->o_private;
 		op->o_private = o_priv;
+		if ( e == NULL && rc != LDAP_NO_SUCH_OBJECT &&
+			rc != LDAP_NO_SUCH_ATTRIBUTE )
+		{
+			cache = 0;
+		}
 	}
 
 	if ( e ) {
-		a = attr_find( e->e_attrs, group_at );
+		a = entry_attr_find( e, group_at );
 		if ( a ) {
 			/* If the attribute is a subtype of labeledURI,
 			 * treat this as a dynamic group ala groupOfURLs
@@ -1620,6 +1964,7 @@ loopit:
 					op->o_private = o_priv;
 				}
 				op->o_bd = b2;
+				cache = 0;
 
 			} else {
 				rc = attr_valfind( a,
@@ -1645,6 +1990,11 @@ loopit:
 		rc = LDAP_NO_SUCH_OBJECT;
 	}
 
+	if ( cache ) {
+		gc_put( op->o_bd, gr_ndn, op_ndn, group_oc, group_at, rc,
+			op->o_hdr->oh_group_gen );
+	}
+
 	if ( op->o_tag != LDAP_REQ_BIND && !op->o_do_not_cache ) {
 		g = op->o_tmpalloc( sizeof( GroupAssertion ) + gr_ndn->bv_len,
 			op->o_tmpmemctx );
@@ -1746,7 +2096,7 @@ fe_acl_attribute(
 			goto freeit;
 		}
 
-		a = attr_find( e->e_attrs, entry_at );
+		a = entry_attr_find( e, entry_at );
 		if ( a == NULL ) {
 			SlapReply	rs = { REP_SEARCH };
 			AttributeName	anlist[ 2 ];
@@ -1913,7 +2263,7 @@ backend_access(
 			}
 
 		} else {
-			a = attr_find( e->e_attrs, entry_at );
+			a = entry_attr_find( e, entry_at );
 			if ( a == NULL ) {
 				SlapReply	rs = { REP_SEARCH };
 				AttributeName	anlist[ 2 ];
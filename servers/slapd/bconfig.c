@@ -200,6 +200,9 @@ enum {
 	CFG_DISABLED,
 	CFG_THREADQS,
 	CFG_TLS_ECNAME,
+	CFG_TLS_KTLS,
+	CFG_TLS_SESSION_CACHE,
+	CFG_TLS_TICKET_ROTATE,
 	CFG_TLS_CACERT,
 	CFG_TLS_CERT,
 	CFG_TLS_KEY,
@@ -358,6 +361,12 @@ static ConfigTable config_back_cf_table[] = {
 		&config_generic, "( OLcfgGlAt:10 NAME 'olcConcurrency' "
 			"EQUALITY integerMatch "
 			"SYNTAX OMsInteger SINGLE-VALUE )", NULL, NULL },
+	{ "conn_max_batch", "max", 2, 2, 0, ARG_INT,
+		&slap_conn_max_batch, "( OLcfgGlAt:102 NAME 'olcConnMaxBatch' "
+			"EQUALITY integerMatch "
+			"SYNTAX OMsInteger SINGLE-VALUE )", NULL,
+			{ .v_int = SLAP_CONN_MAX_BATCH_DEFAULT }
+	},
 	{ "conn_max_pending", "max", 2, 2, 0, ARG_INT,
 		&slap_conn_max_pending, "( OLcfgGlAt:11 NAME 'olcConnMaxPending' "
 			"EQUALITY integerMatch "
@@ -389,10 +398,20 @@ static ConfigTable config_back_cf_table[] = {
 			"SUBSTR caseIgnoreSubstringsMatch "
 			"SYNTAX OMsDirectoryString X-ORDERED 'VALUES' )",
 			NULL, NULL },
+	{ "dn_cache_max", "entries", 2, 2, 0, ARG_INT,
+		&slap_dn_cache_max, "( OLcfgGlAt:108 NAME 'olcDnCacheMax' "
+			"EQUALITY integerMatch "
+			"SYNTAX OMsInteger SINGLE-VALUE )", NULL,
+			{ .v_int = SLAP_DN_CACHE_MAX_DEFAULT }
+	},
 	{ "extra_attrs", "attrlist", 2, 2, 0, ARG_DB|ARG_MAGIC,
 		&config_extra_attrs, "( OLcfgDbAt:0.20 NAME 'olcExtraAttrs' "
 			"EQUALITY caseIgnoreMatch "
 			"SYNTAX OMsDirectoryString )", NULL, NULL },
+	{ "filter_compile", "on|off", 2, 2, 0, ARG_ON_OFF,
+		&slap_filter_compile, "( OLcfgGlAt:109 NAME 'olcFilterCompile' "
+			"EQUALITY booleanMatch "
+			"SYNTAX OMsBoolean SINGLE-VALUE )", NULL, NULL },
 	{ "gentlehup", "on|off", 2, 2, 0,
 #ifdef SIGHUP
 		ARG_ON_OFF, &global_gentlehup,
@@ -402,6 +421,16 @@ static ConfigTable config_back_cf_table[] = {
 		"( OLcfgGlAt:17 NAME 'olcGentleHUP' "
 			"EQUALITY booleanMatch "
 			"SYNTAX OMsBoolean SINGLE-VALUE )", NULL, NULL },
+	{ "group_cache_max", "entries", 2, 2, 0, ARG_INT,
+		&slap_group_cache_max, "( OLcfgGlAt:106 NAME 'olcGroupCacheMax' "
+			"EQUALITY integerMatch "
+			"SYNTAX OMsInteger SINGLE-VALUE )", NULL,
+			{ .v_int = SLAP_GROUP_CACHE_MAX_DEFAULT }
+	},
+	{ "group_cache_ttl", "seconds", 2, 2, 0, ARG_INT,
+		&slap_group_cache_ttl, "( OLcfgGlAt:107 NAME 'olcGroupCacheTTL' "
+			"EQUALITY integerMatch "
+			"SYNTAX OMsInteger SINGLE-VALUE )", NULL, NULL },
 	{ "hidden", "on|off", 2, 2, 0, ARG_DB|ARG_ON_OFF|ARG_MAGIC|CFG_HIDDEN,
 		&config_generic, "( OLcfgDbAt:0.17 NAME 'olcHidden' "
 			"EQUALITY booleanMatch "
@@ -439,6 +468,10 @@ static ConfigTable config_back_cf_table[] = {
 			"EQUALITY integerMatch "
 			"SYNTAX OMsInteger SINGLE-VALUE )", NULL,
 			{ .v_uint = SLAP_INDEX_SUBSTR_ANY_STEP_DEFAULT } },
+	{ "index_substr_exact", "on|off", 2, 2, 0, ARG_ON_OFF,
+		&index_substr_exact, "( OLcfgGlAt:110 NAME 'olcIndexSubstrExact' "
+			"EQUALITY booleanMatch "
+			"SYNTAX OMsBoolean SINGLE-VALUE )", NULL, NULL },
 	{ "index_intlen", "len", 2, 2, 0, ARG_UINT|ARG_MAGIC|CFG_IX_INTLEN,
 		&config_generic, "( OLcfgGlAt:84 NAME 'olcIndexIntLen' "
 			"EQUALITY integerMatch "
@@ -893,6 +926,33 @@ static ConfigTable config_back_cf_table[] = {
 		"( OLcfgGlAt:96 NAME 'olcTLSECName' "
 			"EQUALITY caseExactMatch "
 			"SYNTAX OMsDirectoryString SINGLE-VALUE )", NULL, NULL },
+	{ "TLSKTLS", NULL, 2, 2, 0,
+#if defined(HAVE_TLS) && defined(HAVE_OPENSSL)
+		CFG_TLS_KTLS|ARG_STRING|ARG_MAGIC, &config_tls_config,
+#else
+		ARG_IGNORED, NULL,
+#endif
+		"( OLcfgGlAt:103 NAME 'olcTLSKTLS' "
+			"EQUALITY booleanMatch "
+			"SYNTAX OMsBoolean SINGLE-VALUE )", NULL, NULL },
+	{ "TLSSessionCache", "entries", 2, 2, 0,
+#ifdef HAVE_TLS
+		CFG_TLS_SESSION_CACHE|ARG_STRING|ARG_MAGIC, &config_tls_config,
+#else
+		ARG_IGNORED, NULL,
+#endif
+		"( OLcfgGlAt:104 NAME 'olcTLSSessionCache' "
+			"EQUALITY integerMatch "
+			"SYNTAX OMsInteger SINGLE-VALUE )", NULL, NULL },
+	{ "TLSTicketRotate", "seconds", 2, 2, 0,
+#ifdef HAVE_TLS
+		CFG_TLS_TICKET_ROTATE|ARG_STRING|ARG_MAGIC, &config_tls_config,
+#else
+		ARG_IGNORED, NULL,
+#endif
+		"( OLcfgGlAt:105 NAME 'olcTLSTicketRotate' "
+			"EQUALITY integerMatch "
+			"SYNTAX OMsInteger SINGLE-VALUE )", NULL, NULL },
 	{ "TLSProtocolMin",	NULL, 2, 2, 0,
 #ifdef HAVE_TLS
 		CFG_TLS_PROTOCOL_MIN|ARG_STRING|ARG_MAGIC, &config_tls_config,
@@ -967,10 +1027,12 @@ static ConfigOCs cf_ocs[] = {
 		"MAY ( cn $ olcConfigFile $ olcConfigDir $ olcAllows $ olcArgsFile $ "
 		 "olcAttributeOptions $ olcAuthIDRewrite $ "
 		 "olcAuthzPolicy $ olcAuthzRegexp $ olcConcurrency $ "
-		 "olcConnMaxPending $ olcConnMaxPendingAuth $ "
-		 "olcDisallows $ olcGentleHUP $ olcIdleTimeout $ "
+		 "olcConnMaxBatch $ olcConnMaxPending $ olcConnMaxPendingAuth $ "
+		 "olcDisallows $ olcDnCacheMax $ olcFilterCompile $ olcGentleHUP $ olcGroupCacheMax $ olcGroupCacheTTL $ "
+		 "olcIdleTimeout $ "
 		 "olcIndexSubstrIfMaxLen $ olcIndexSubstrIfMinLen $ "
-		 "olcIndexSubstrAnyLen $ olcIndexSubstrAnyStep $ olcIndexHash64 $ "
+		 "olcIndexSubstrAnyLen $ olcIndexSubstrAnyStep $ olcIndexSubstrExact $ "
+		 "olcIndexHash64 $ "
 		 "olcIndexIntLen $ "
 		 "olcListenerThreads $ olcLocalSSF $ olcLogFile $ olcLogLevel $ "
 		 "olcMaxFilterDepth $ "
@@ -988,7 +1050,8 @@ static ConfigOCs cf_ocs[] = {
 		 "olcTLSCACertificatePath $ olcTLSCertificateFile $ "
 		 "olcTLSCertificateKeyFile $ olcTLSCipherSuite $ olcTLSCRLCheck $ "
 		 "olcTLSCACertificate $ olcTLSCertificate $ olcTLSCertificateKey $ "
-		 "olcTLSRandFile $ olcTLSVerifyClient $ olcTLSDHParamFile $ olcTLSECName $ "
+		 "olcTLSRandFile $ olcTLSVerifyClient $ olcTLSDHParamFile $ olcTLSECName $ olcTLSKTLS $ "
+		 "olcTLSSessionCache $ olcTLSTicketRotate $ "
 		 "olcTLSCRLFile $ olcTLSProtocolMin $ olcToolThreads $ olcWriteTimeout $ "
 		 "olcObjectIdentifier $ olcAttributeTypes $ olcObjectClasses $ "
 		 "olcDitContentRules $ olcLdapSyntaxes ) )", Cft_Global },
@@ -4330,6 +4393,11 @@ config_tls_config(ConfigArgs *c) {
 	case CFG_TLS_CRLCHECK:	flag = LDAP_OPT_X_TLS_CRLCHECK; break;
 	case CFG_TLS_VERIFY:	flag = LDAP_OPT_X_TLS_REQUIRE_CERT; break;
 	case CFG_TLS_PROTOCOL_MIN: flag = LDAP_OPT_X_TLS_PROTOCOL_MIN; break;
+	case CFG_TLS_SESSION_CACHE:	flag = LDAP_OPT_X_TLS_SESSION_CACHE; break;
+	case CFG_TLS_TICKET_ROTATE:	flag = LDAP_OPT_X_TLS_TICKET_ROTATE; break;
+#ifdef HAVE_OPENSSL
+	case CFG_TLS_KTLS:	flag = LDAP_OPT_X_TLS_KTLS; break;
+#endif
 	default:
 		Debug(LDAP_DEBUG_ANY, "%s: "
 				"unknown tls_option <0x%x>\n",
@@ -4345,7 +4413,8 @@ config_tls_config(ConfigArgs *c) {
 	}
 	ch_free( c->value_string );
 	config_push_cleanup( c, config_tls_cleanup );
-	if ( isdigit( (unsigned char)c->argv[1][0] ) && c->type != CFG_TLS_PROTOCOL_MIN ) {
+	if ( isdigit( (unsigned char)c->argv[1][0] ) && c->type != CFG_TLS_PROTOCOL_MIN &&
+		c->type != CFG_TLS_KTLS ) {
 		if ( lutil_atoi( &i, c->argv[1] ) != 0 ) {
 			Debug(LDAP_DEBUG_ANY, "%s: "
 				"unable to parse %s \"%s\"\n",
@@ -83,8 +83,15 @@ ber_len_t sockbuf_max_incoming_auth= SLAP_SB_MAX_INCOMING_AUTH;
 
 int	slap_conn_max_pending = SLAP_CONN_MAX_PENDING_DEFAULT;
 int	slap_conn_max_pending_auth = SLAP_CONN_MAX_PENDING_AUTH;
+int	slap_conn_max_batch = SLAP_CONN_MAX_BATCH_DEFAULT;
+
+int	slap_group_cache_max = SLAP_GROUP_CACHE_MAX_DEFAULT;
+int	slap_group_cache_ttl = 0;
+
+int	slap_dn_cache_max = SLAP_DN_CACHE_MAX_DEFAULT;
 
 int	slap_max_filter_depth = SLAP_MAX_FILTER_DEPTH_DEFAULT;
+int	slap_filter_compile = 0;
 
 char   *slapd_pid_file  = NULL;
 char   *slapd_args_file = NULL;
@@ -1804,6 +1811,20 @@ slap_tls_get_config( LDAP *ld, int opt, char **val )
 		*val = ch_strdup( buf );
 		return 0;
 		}
+	case LDAP_OPT_X_TLS_SESSION_CACHE:
+	case LDAP_OPT_X_TLS_TICKET_ROTATE: {
+		char buf[LDAP_PVT_INTTYPE_CHARS(int)];
+		ldap_pvt_tls_get_option( ld, opt, &ival );
+		snprintf( buf, sizeof( buf ), "%d", ival );
+		*val = ch_strdup( buf );
+		return 0;
+		}
+#ifdef HAVE_OPENSSL
+	case LDAP_OPT_X_TLS_KTLS:
+		ldap_pvt_tls_get_option( ld, opt, &ival );
+		*val = ch_strdup( ival ? "TRUE" : "FALSE" );
+		return 0;
+#endif
 	default:
 		return -1;
 	}
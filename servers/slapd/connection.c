@@ -77,6 +77,8 @@ typedef struct conn_readinfo {
 	void *arg;
 	void *ctx;
 	int nullop;
+	int nbatch;		/* number of ops chained on op via o_bnext */
+	Operation **tail;
 } conn_readinfo;
 
 static int connection_input( Connection *c, conn_readinfo *cri );
@@ -89,6 +91,7 @@ static void connection_abandon( Connection *conn );
 static void connection_destroy( Connection *c );
 
 static ldap_pvt_thread_start_t connection_operation;
+static ldap_pvt_thread_start_t connection_operation_batch;
 
 /*
  * Initialize connection management infrastructure.
@@ -474,6 +477,28 @@ Connection * connection_init(
 #endif
 		ber_sockbuf_add_io( c->c_sb, &ber_sockbuf_io_tcp,
 			LBER_SBIOD_LEVEL_PROVIDER, (void *)&sfd );
+#ifdef LDAP_TCP_BUFFER
+		/* When a read buffer size is configured for the listener,
+		 * also buffer incoming data in userspace so that small
+		 * pipelined requests are not read piecemeal.
+		 */
+		if ( !( flags & CONN_IS_CLIENT ) ) {
+			int size = 0;
+
+			if ( listener->sl_tcp_rmem > 0 ) {
+				size = listener->sl_tcp_rmem;
+			} else if ( slapd_tcp_rmem > 0 ) {
+				size = slapd_tcp_rmem;
+			}
+			if ( size > SLAP_SB_MAX_READAHEAD ) {
+				size = SLAP_SB_MAX_READAHEAD;
+			}
+			if ( size > 0 ) {
+				ber_sockbuf_add_io( c->c_sb, &ber_sockbuf_io_readahead,
+					LBER_SBIOD_LEVEL_PROVIDER, (void *)&size );
+			}
+		}
+#endif /* LDAP_TCP_BUFFER */
 	}
 
 #ifdef LDAP_DEBUG
@@ -912,6 +937,9 @@ void connection_done( Connection *c )
 		ldap_pvt_thread_mutex_lock( &op->o_counters->sc_mutex ); \
 		ldap_pvt_mp_add_ulong(op->o_counters->sc_ops_completed, 1); \
 		ldap_pvt_mp_add_ulong(op->o_counters->sc_ops_completed_[(index)], 1); \
+		ldap_pvt_mp_add_ulong(op->o_counters->sc_acl_evals, op->o_hdr->oh_acl_evals); \
+		ldap_pvt_mp_add_ulong(op->o_counters->sc_acl_rules, op->o_hdr->oh_acl_rules); \
+		ldap_pvt_mp_add_ulong(op->o_counters->sc_acl_skipped, op->o_hdr->oh_acl_skipped); \
 		ldap_pvt_thread_mutex_unlock( &op->o_counters->sc_mutex ); \
 	} while (0)
 
@@ -957,6 +985,9 @@ conn_counter_destroy( void *key, void *data )
 				ldap_pvt_mp_add( slap_counters.sc_ops_initiated_[ i ], sc->sc_ops_initiated_[ i ] );
 				ldap_pvt_mp_add( slap_counters.sc_ops_initiated_[ i ], sc->sc_ops_completed_[ i ] );
 			}
+			ldap_pvt_mp_add( slap_counters.sc_acl_evals, sc->sc_acl_evals );
+			ldap_pvt_mp_add( slap_counters.sc_acl_rules, sc->sc_acl_rules );
+			ldap_pvt_mp_add( slap_counters.sc_acl_skipped, sc->sc_acl_skipped );
 			slap_counters_destroy( sc );
 			ber_memfree_x( data, NULL );
 			break;
@@ -1038,6 +1069,9 @@ connection_operation( void *ctx, void *arg_v )
 	ldap_pvt_mp_add_ulong(op->o_counters->sc_ops_initiated, 1);
 	ldap_pvt_thread_mutex_unlock( &op->o_counters->sc_mutex );
 
+	if ( slap_group_cache_max > 0 )
+		op->o_hdr->oh_group_gen = slap_group_cache_gen();
+
 	op->o_threadctx = ctx;
 	op->o_tid = ldap_pvt_thread_pool_tid( ctx );
 
@@ -1188,6 +1222,56 @@ operations_error:
 	return NULL;
 }
 
+/*
+ * Execute a chain of cheap operations read in the same wakeup
+ * back-to-back in a single thread.
+ */
+static void *
+connection_operation_batch( void *ctx, void *arg_v )
+{
+	Operation *op, *next;
+	void *rc = NULL;
+
+	for ( op = arg_v; op; op = next ) {
+		next = op->o_bnext;
+		op->o_bnext = NULL;
+		rc = connection_operation( ctx, op );
+	}
+	return rc;
+}
+
+/*
+ * Only requests that are expected to complete quickly are
+ * eligible for batching: compares and baseObject searches.
+ */
+static int
+connection_op_batchable( Operation *op )
+{
+	switch ( op->o_tag ) {
+	case LDAP_REQ_COMPARE:
+		return 1;
+
+	case LDAP_REQ_SEARCH: {
+		BerElementBuffer berbuf;
+		BerElement *ber = (BerElement *)&berbuf;
+		struct berval bv;
+		ber_int_t scope;
+
+		/* peek at the scope without consuming the request */
+		if ( ber_peek_element( op->o_ber, &bv ) == LBER_DEFAULT )
+			return 0;
+		ber_init2( ber, &bv, 0 );
+		if ( ber_scanf( ber, "xe", &scope ) == LBER_ERROR )
+			return 0;
+		return scope == LDAP_SCOPE_BASE;
+		}
+
+	default:
+		break;
+	}
+	return 0;
+}
+
 static const Listener dummy_list = { BER_BVC(""), BER_BVC("") };
 
 Connection *connection_client_setup(
@@ -1247,7 +1331,7 @@ static int connection_read( ber_socket_t s, conn_readinfo *cri );
 static void* connection_read_thread( void* ctx, void* argv )
 {
 	int rc ;
-	conn_readinfo cri = { NULL, NULL, NULL, NULL, 0 };
+	conn_readinfo cri = { NULL, NULL, NULL, NULL, 0, 0, NULL };
 	ber_socket_t s = (long)argv;
 
 	/*
@@ -1260,9 +1344,10 @@ static void* connection_read_thread( void* ctx, void* argv )
 		return (void*)(long)rc;
 	}
 
-	/* execute a single queued request in the same thread */
+	/* execute a single queued request, or a batch of cheap
+	 * requests, in the same thread */
 	if( cri.op && !cri.nullop ) {
-		rc = (long)connection_operation( ctx, cri.op );
+		rc = (long)connection_operation_batch( ctx, cri.op );
 	} else if ( cri.func ) {
 		rc = (long)cri.func( ctx, cri.arg );
 	}
@@ -1695,7 +1780,8 @@ connection_input( Connection *conn , conn_readinfo *cri )
 
 		/*
 		 * The first op will be processed in the same thread context,
-		 * as long as there is only one op total.
+		 * as long as there is only one op total, or as long as all
+		 * ops read so far are cheap and conn_max_batch allows it.
 		 * Subsequent ops will be submitted to the pool by
 		 * calling connection_op_activate()
 		 */
@@ -1703,11 +1789,21 @@ connection_input( Connection *conn , conn_readinfo *cri )
 			/* the first incoming request */
 			connection_op_queue( op );
 			cri->op = op;
+			cri->nbatch = 1;
+			cri->tail = &op->o_bnext;
+		} else if ( !cri->nullop && cri->nbatch < slap_conn_max_batch &&
+			connection_op_batchable( op ) &&
+			( cri->nbatch > 1 || connection_op_batchable( cri->op ))) {
+			/* chain it to the current batch */
+			connection_op_queue( op );
+			*cri->tail = op;
+			cri->tail = &op->o_bnext;
+			cri->nbatch++;
 		} else {
 			if ( !cri->nullop ) {
 				cri->nullop = 1;
 				rc = ldap_pvt_thread_pool_submit( &connection_pool,
-					connection_operation, (void *) cri->op );
+					connection_operation_batch, (void *) cri->op );
 			}
 			connection_op_activate( op );
 		}
@@ -413,6 +413,213 @@ LDAPDN_rewrite( LDAPDN dn, unsigned flags, void *ctx )
 	return LDAP_SUCCESS;
 }
 
+/*
+ * Cache of the pretty and normalized forms of recently seen DN strings,
+ * split in stripes selected by a hash of the string so that threads
+ * normalizing different DNs rarely contend.  Only successful results
+ * are cached, and a hit therefore also validates the string.  Each
+ * stripe keeps an LRU list and at most slap_dn_cache_max/DNC_STRIPES
+ * entries.
+ */
+#define DNC_STRIPES	16
+
+typedef struct dnc_entry {
+	struct berval	de_raw;
+	struct berval	de_pretty;	/* BER_BVNULL until computed */
+	struct berval	de_normal;	/* BER_BVNULL until computed */
+	struct dnc_entry	*de_next, *de_prev;	/* LRU, most recent first */
+} dnc_entry;
+
+static struct dnc_stripe {
+	ldap_pvt_thread_mutex_t	ds_mutex;
+	Avlnode		*ds_tree;
+	dnc_entry	*ds_head, *ds_tail;
+	int		ds_count;
+	unsigned long	ds_hits, ds_misses;
+} dnc_stripes[ DNC_STRIPES ];
+
+static int
+dnc_cmp( const void *v1, const void *v2 )
+{
+	const dnc_entry *e1 = v1, *e2 = v2;
+
+	if ( e1->de_raw.bv_len != e2->de_raw.bv_len )
+		return e1->de_raw.bv_len < e2->de_raw.bv_len ? -1 : 1;
+	return memcmp( e1->de_raw.bv_val, e2->de_raw.bv_val, e1->de_raw.bv_len );
+}
+
+static struct dnc_stripe *
+dnc_stripe( struct berval *val )
+{
+	unsigned int h = 2166136261U;
+	ber_len_t i;
+
+	for ( i = 0; i < val->bv_len; i++ ) {
+		h ^= (unsigned char)val->bv_val[i];
+		h *= 16777619U;
+	}
+	return &dnc_stripes[ h % DNC_STRIPES ];
+}
+
+static void
+dnc_unlink( struct dnc_stripe *ds, dnc_entry *de )
+{
+	if ( de->de_prev )
+		de->de_prev->de_next = de->de_next;
+	else
+		ds->ds_head = de->de_next;
+	if ( de->de_next )
+		de->de_next->de_prev = de->de_prev;
+	else
+		ds->ds_tail = de->de_prev;
+}
+
+static void
+dnc_push( struct dnc_stripe *ds, dnc_entry *de )
+{
+	de->de_prev = NULL;
+	de->de_next = ds->ds_head;
+	if ( ds->ds_head )
+		ds->ds_head->de_prev = de;
+	else
+		ds->ds_tail = de;
+	ds->ds_head = de;
+}
+
+static void
+dnc_free( struct dnc_stripe *ds, dnc_entry *de )
+{
+	ldap_avl_delete( &ds->ds_tree, de, dnc_cmp );
+	dnc_unlink( ds, de );
+	ds->ds_count--;
+	ch_free( de->de_pretty.bv_val );
+	ch_free( de->de_normal.bv_val );
+	ch_free( de );
+}
+
+void
+dn_cache_init( void )
+{
+	int i;
+
+	for ( i = 0; i < DNC_STRIPES; i++ )
+		ldap_pvt_thread_mutex_init( &dnc_stripes[i].ds_mutex );
+}
+
+void
+dn_cache_flush( void )
+{
+	int i;
+
+	for ( i = 0; i < DNC_STRIPES; i++ ) {
+		struct dnc_stripe *ds = &dnc_stripes[i];
+
+		ldap_pvt_thread_mutex_lock( &ds->ds_mutex );
+		while ( ds->ds_head )
+			dnc_free( ds, ds->ds_head );
+		ldap_pvt_thread_mutex_unlock( &ds->ds_mutex );
+	}
+}
+
+void
+dn_cache_destroy( void )
+{
+	int i;
+
+	dn_cache_flush();
+	for ( i = 0; i < DNC_STRIPES; i++ )
+		ldap_pvt_thread_mutex_destroy( &dnc_stripes[i].ds_mutex );
+}
+
+void
+dn_cache_stats( slap_dn_cache_stats_t *ds )
+{
+	int i;
+
+	memset( ds, 0, sizeof( *ds ) );
+	for ( i = 0; i < DNC_STRIPES; i++ ) {
+		ldap_pvt_thread_mutex_lock( &dnc_stripes[i].ds_mutex );
+		ds->ds_hits += dnc_stripes[i].ds_hits;
+		ds->ds_misses += dnc_stripes[i].ds_misses;
+		ds->ds_entries += dnc_stripes[i].ds_count;
+		ldap_pvt_thread_mutex_unlock( &dnc_stripes[i].ds_mutex );
+	}
+}
+
+/*
+ * Copy the cached forms of val that are requested (pretty and/or
+ * normal may be NULL) into ctx memory; fails unless all of them
+ * are cached.
+ */
+static int
+dnc_get( struct berval *val, struct berval *pretty, struct berval *normal,
+	void *ctx )
+{
+	struct dnc_stripe *ds = dnc_stripe( val );
+	dnc_entry tmp, *de;
+	int rc = -1;
+
+	tmp.de_raw = *val;
+	ldap_pvt_thread_mutex_lock( &ds->ds_mutex );
+	de = ldap_avl_find( ds->ds_tree, &tmp, dnc_cmp );
+	if ( de && ( !pretty || de->de_pretty.bv_val ) &&
+		( !normal || de->de_normal.bv_val ) )
+	{
+		if ( ds->ds_head != de ) {
+			dnc_unlink( ds, de );
+			dnc_push( ds, de );
+		}
+		if ( pretty )
+			ber_dupbv_x( pretty, &de->de_pretty, ctx );
+		if ( normal )
+			ber_dupbv_x( normal, &de->de_normal, ctx );
+		ds->ds_hits++;
+		rc = 0;
+	} else {
+		ds->ds_misses++;
+	}
+	ldap_pvt_thread_mutex_unlock( &ds->ds_mutex );
+
+	return rc;
+}
+
+static void
+dnc_put( struct berval *val, struct berval *pretty, struct berval *normal )
+{
+	struct dnc_stripe *ds = dnc_stripe( val );
+	int max = slap_dn_cache_max / DNC_STRIPES;
+	dnc_entry tmp, *de;
+
+	/* lenient parsing (slapadd, cn=config load) may accept unknown
+	 * attribute types, don't let those results outlive it */
+	if ( !slap_DN_strict )
+		return;
+
+	if ( max < 1 )
+		max = 1;
+
+	tmp.de_raw = *val;
+	ldap_pvt_thread_mutex_lock( &ds->ds_mutex );
+	de = ldap_avl_find( ds->ds_tree, &tmp, dnc_cmp );
+	if ( de == NULL ) {
+		de = ch_calloc( 1, sizeof( dnc_entry ) + val->bv_len + 1 );
+		de->de_raw.bv_len = val->bv_len;
+		de->de_raw.bv_val = (char *)( de + 1 );
+		AC_MEMCPY( de->de_raw.bv_val, val->bv_val, val->bv_len );
+		ldap_avl_insert( &ds->ds_tree, de, dnc_cmp, ldap_avl_dup_error );
+		dnc_push( ds, de );
+		ds->ds_count++;
+	}
+	if ( pretty && !de->de_pretty.bv_val )
+		ber_dupbv( &de->de_pretty, pretty );
+	if ( normal && !de->de_normal.bv_val )
+		ber_dupbv( &de->de_normal, normal );
+
+	while ( ds->ds_count > max )
+		dnc_free( ds, ds->ds_tail );
+	ldap_pvt_thread_mutex_unlock( &ds->ds_mutex );
+}
+
 int
 dnNormalize(
     slap_mask_t use,
@@ -427,7 +634,12 @@ dnNormalize(
 
 	Debug( LDAP_DEBUG_TRACE, ">>> dnNormalize: <%s>\n", val->bv_val ? val->bv_val : "" );
 
-	if ( val->bv_len != 0 ) {
+	if ( val->bv_len != 0 && slap_dn_cache_max > 0 &&
+		dnc_get( val, NULL, out, ctx ) == 0 )
+	{
+		/* cached */
+
+	} else if ( val->bv_len != 0 ) {
 		LDAPDN		dn = NULL;
 		int		rc;
 
@@ -460,6 +672,9 @@ dnNormalize(
 		if ( rc != LDAP_SUCCESS ) {
 			return LDAP_INVALID_SYNTAX;
 		}
+
+		if ( slap_dn_cache_max > 0 )
+			dnc_put( val, NULL, out );
 	} else {
 		ber_dupbv_x( out, val, ctx );
 	}
@@ -545,6 +760,11 @@ dnPretty(
 	} else if ( val->bv_len > SLAP_LDAPDN_MAXLEN ) {
 		return LDAP_INVALID_SYNTAX;
 
+	} else if ( slap_dn_cache_max > 0 &&
+		dnc_get( val, out, NULL, ctx ) == 0 )
+	{
+		/* cached */
+
 	} else {
 		LDAPDN		dn = NULL;
 		int		rc;
@@ -577,6 +797,9 @@ dnPretty(
 		if ( rc != LDAP_SUCCESS ) {
 			return LDAP_INVALID_SYNTAX;
 		}
+
+		if ( slap_dn_cache_max > 0 )
+			dnc_put( val, out, NULL );
 	}
 
 	Debug( LDAP_DEBUG_TRACE, "<<< dnPretty: <%s>\n", out->bv_val ? out->bv_val : "" );
@@ -716,6 +939,11 @@ dnPrettyNormal(
 		/* too big */
 		return LDAP_INVALID_SYNTAX;
 
+	} else if ( slap_dn_cache_max > 0 &&
+		dnc_get( val, pretty, normal, ctx ) == 0 )
+	{
+		/* cached */
+
 	} else {
 		LDAPDN		dn = NULL;
 		int		rc;
@@ -767,6 +995,9 @@ dnPrettyNormal(
 			pretty->bv_len = 0;
 			return LDAP_INVALID_SYNTAX;
 		}
+
+		if ( slap_dn_cache_max > 0 )
+			dnc_put( val, pretty, normal );
 	}
 
 	Debug( LDAP_DEBUG_TRACE, "<<< dnPrettyNormal: <%s>, <%s>\n",
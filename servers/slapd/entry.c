@@ -44,7 +44,7 @@ static int		emaxsize;/* max size of ebuf			 */
  * Empty root entry
  */
 const Entry slap_entry_root = {
-	NOID, { 0, "" }, { 0, "" }, NULL, 0, { 0, "" }, NULL
+	NOID, { 0, "" }, { 0, "" }, NULL, NULL, 0, { 0, "" }, NULL
 };
 
 /*
@@ -471,6 +471,7 @@ entry_clean( Entry *e )
 		attrs_free( e->e_attrs );
 		e->e_attrs = NULL;
 	}
+	e->e_attrindex = NULL;
 
 	e->e_ocflags = 0;
 }
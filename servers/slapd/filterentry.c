@@ -39,13 +39,17 @@
 
 static int	test_filter_and( Operation *op, Entry *e, Filter *flist );
 static int	test_filter_or( Operation *op, Entry *e, Filter *flist );
-static int	test_substrings_filter( Operation *op, Entry *e, Filter *f);
+static int	test_substrings_filter( Operation *op, Entry *e, Filter *f,
+	AccessControlState *state, Attribute *a );
 static int	test_ava_filter( Operation *op,
-	Entry *e, AttributeAssertion *ava, int type );
+	Entry *e, AttributeAssertion *ava, int type,
+	AccessControlState *state, Attribute *a );
 static int	test_mra_filter( Operation *op,
-	Entry *e, MatchingRuleAssertion *mra );
+	Entry *e, MatchingRuleAssertion *mra,
+	AccessControlState *state, Attribute *a );
 static int	test_presence_filter( Operation *op,
-	Entry *e, AttributeDescription *desc );
+	Entry *e, AttributeDescription *desc,
+	AccessControlState *state, Attribute *a );
 
 
 /*
@@ -85,32 +89,38 @@ test_filter(
 
 	case LDAP_FILTER_EQUALITY:
 		Debug( LDAP_DEBUG_FILTER, "    EQUALITY\n" );
-		rc = test_ava_filter( op, e, f->f_ava, LDAP_FILTER_EQUALITY );
+		rc = test_ava_filter( op, e, f->f_ava, LDAP_FILTER_EQUALITY,
+			NULL, entry_attrs_find( e, f->f_av_desc ) );
 		break;
 
 	case LDAP_FILTER_SUBSTRINGS:
 		Debug( LDAP_DEBUG_FILTER, "    SUBSTRINGS\n" );
-		rc = test_substrings_filter( op, e, f );
+		rc = test_substrings_filter( op, e, f,
+			NULL, entry_attrs_find( e, f->f_sub_desc ) );
 		break;
 
 	case LDAP_FILTER_GE:
 		Debug( LDAP_DEBUG_FILTER, "    GE\n" );
-		rc = test_ava_filter( op, e, f->f_ava, LDAP_FILTER_GE );
+		rc = test_ava_filter( op, e, f->f_ava, LDAP_FILTER_GE,
+			NULL, entry_attrs_find( e, f->f_av_desc ) );
 		break;
 
 	case LDAP_FILTER_LE:
 		Debug( LDAP_DEBUG_FILTER, "    LE\n" );
-		rc = test_ava_filter( op, e, f->f_ava, LDAP_FILTER_LE );
+		rc = test_ava_filter( op, e, f->f_ava, LDAP_FILTER_LE,
+			NULL, entry_attrs_find( e, f->f_av_desc ) );
 		break;
 
 	case LDAP_FILTER_PRESENT:
 		Debug( LDAP_DEBUG_FILTER, "    PRESENT\n" );
-		rc = test_presence_filter( op, e, f->f_desc );
+		rc = test_presence_filter( op, e, f->f_desc,
+			NULL, entry_attrs_find( e, f->f_desc ) );
 		break;
 
 	case LDAP_FILTER_APPROX:
 		Debug( LDAP_DEBUG_FILTER, "    APPROX\n" );
-		rc = test_ava_filter( op, e, f->f_ava, LDAP_FILTER_APPROX );
+		rc = test_ava_filter( op, e, f->f_ava, LDAP_FILTER_APPROX,
+			NULL, entry_attrs_find( e, f->f_av_desc ) );
 		break;
 
 	case LDAP_FILTER_AND:
@@ -142,7 +152,8 @@ test_filter(
 
 	case LDAP_FILTER_EXT:
 		Debug( LDAP_DEBUG_FILTER, "    EXT\n" );
-		rc = test_mra_filter( op, e, f->f_mra );
+		rc = test_mra_filter( op, e, f->f_mra, NULL, f->f_mr_desc ?
+			entry_attrs_find( e, f->f_mr_desc ) : NULL );
 		break;
 
 	default:
@@ -158,9 +169,10 @@ out:
 static int test_mra_filter(
 	Operation *op,
 	Entry *e,
-	MatchingRuleAssertion *mra )
+	MatchingRuleAssertion *mra,
+	AccessControlState *state,
+	Attribute *a )
 {
-	Attribute	*a;
 	void		*memctx;
 	BER_MEMFREE_FN	*memfree;
 #ifdef LDAP_COMP_MATCH
@@ -182,7 +194,7 @@ static int test_mra_filter(
 		 * directly.
 		 */
 		if ( !access_allowed( op, e,
-			mra->ma_desc, &mra->ma_value, ACL_SEARCH, NULL ) )
+			mra->ma_desc, &mra->ma_value, ACL_SEARCH, state ) )
 		{
 			return LDAP_INSUFFICIENT_ACCESS;
 		}
@@ -200,9 +212,8 @@ static int test_mra_filter(
 			return LDAP_COMPARE_FALSE;
 		}
 
-		for ( a = attrs_find( e->e_attrs, mra->ma_desc );
-			a != NULL;
-			a = attrs_find( a->a_next, mra->ma_desc ) )
+		for ( ; a != NULL;
+			a = entry_attrs_find_next( e, a, mra->ma_desc ) )
 		{
 			struct berval	*bv;
 			int		normalize_attribute = 0;
@@ -346,7 +357,7 @@ static int test_mra_filter(
 
 			/* check search access */
 			if ( !access_allowed( op, e,
-				a->a_desc, &value, ACL_SEARCH, NULL ) )
+				a->a_desc, &value, ACL_SEARCH, state ) )
 			{
 				memfree( value.bv_val, memctx );
 				continue;
@@ -471,7 +482,7 @@ static int test_mra_filter(
 
 					/* check search access */
 					if ( !access_allowed( op, e,
-						ad, &value, ACL_SEARCH, NULL ) )
+						ad, &value, ACL_SEARCH, state ) )
 					{
 						memfree( value.bv_val, memctx );
 						continue;
@@ -528,17 +539,18 @@ test_ava_filter(
 	Operation	*op,
 	Entry		*e,
 	AttributeAssertion *ava,
-	int		type )
+	int		type,
+	AccessControlState *state,
+	Attribute	*a )
 {
 	int rc;
-	Attribute	*a;
 #ifdef LDAP_COMP_MATCH
 	int i, num_attr_vals = 0;
 	AttributeAliasing *a_alias = NULL;
 #endif
 
 	if ( !access_allowed( op, e,
-		ava->aa_desc, &ava->aa_value, ACL_SEARCH, NULL ) )
+		ava->aa_desc, &ava->aa_value, ACL_SEARCH, state ) )
 	{
 		return LDAP_INSUFFICIENT_ACCESS;
 	}
@@ -605,23 +617,23 @@ test_ava_filter(
 	if ( is_aliased_attribute && ava->aa_cf )
 	{
 		a_alias = is_aliased_attribute ( ava->aa_desc );
-		if ( a_alias )
+		if ( a_alias ) {
 			ava->aa_desc = a_alias->aa_aliased_ad;
-		else
+			a = entry_attrs_find( e, ava->aa_desc );
+		} else
 			ava->aa_cf = NULL;
 	}
 #endif
 
-	for(a = attrs_find( e->e_attrs, ava->aa_desc );
-		a != NULL;
-		a = attrs_find( a->a_next, ava->aa_desc ) )
+	for( ; a != NULL;
+		a = entry_attrs_find_next( e, a, ava->aa_desc ) )
 	{
 		int use;
 		MatchingRule *mr;
 		struct berval *bv;
 
 		if (( ava->aa_desc != a->a_desc ) && !access_allowed( op,
-			e, a->a_desc, &ava->aa_value, ACL_SEARCH, NULL ))
+			e, a->a_desc, &ava->aa_value, ACL_SEARCH, state ))
 		{
 			rc = LDAP_INSUFFICIENT_ACCESS;
 			continue;
@@ -813,12 +825,13 @@ static int
 test_presence_filter(
 	Operation	*op,
 	Entry		*e,
-	AttributeDescription *desc )
+	AttributeDescription *desc,
+	AccessControlState *state,
+	Attribute	*a )
 {
-	Attribute	*a;
 	int rc;
 
-	if ( !access_allowed( op, e, desc, NULL, ACL_SEARCH, NULL ) ) {
+	if ( !access_allowed( op, e, desc, NULL, ACL_SEARCH, state ) ) {
 		return LDAP_INSUFFICIENT_ACCESS;
 	}
 
@@ -845,12 +858,9 @@ test_presence_filter(
 
 	rc = LDAP_COMPARE_FALSE;
 
-	for(a = attrs_find( e->e_attrs, desc );
-		a != NULL;
-		a = attrs_find( a->a_next, desc ) )
-	{
+	for( ; a != NULL; a = entry_attrs_find_next( e, a, desc ) ) {
 		if (( desc != a->a_desc ) && !access_allowed( op,
-			e, a->a_desc, NULL, ACL_SEARCH, NULL ))
+			e, a->a_desc, NULL, ACL_SEARCH, state ))
 		{
 			rc = LDAP_INSUFFICIENT_ACCESS;
 			continue;
@@ -930,30 +940,30 @@ static int
 test_substrings_filter(
 	Operation	*op,
 	Entry	*e,
-	Filter	*f )
+	Filter	*f,
+	AccessControlState *state,
+	Attribute	*a )
 {
-	Attribute	*a;
 	int rc;
 
 	Debug( LDAP_DEBUG_FILTER, "begin test_substrings_filter\n" );
 
 	if ( !access_allowed( op, e,
-		f->f_sub_desc, NULL, ACL_SEARCH, NULL ) )
+		f->f_sub_desc, NULL, ACL_SEARCH, state ) )
 	{
 		return LDAP_INSUFFICIENT_ACCESS;
 	}
 
 	rc = LDAP_COMPARE_FALSE;
 
-	for(a = attrs_find( e->e_attrs, f->f_sub_desc );
-		a != NULL;
-		a = attrs_find( a->a_next, f->f_sub_desc ) )
+	for( ; a != NULL;
+		a = entry_attrs_find_next( e, a, f->f_sub_desc ) )
 	{
 		MatchingRule *mr;
 		struct berval *bv;
 
 		if (( f->f_sub_desc != a->a_desc ) && !access_allowed( op,
-			e, a->a_desc, NULL, ACL_SEARCH, NULL ))
+			e, a->a_desc, NULL, ACL_SEARCH, state ))
 		{
 			rc = LDAP_INSUFFICIENT_ACCESS;
 			continue;
@@ -984,3 +994,369 @@ test_substrings_filter(
 		rc );
 	return rc;
 }
+
+/*
+ * Compiled filters.
+ *
+ * A search that tests many candidates can flatten its filter once into
+ * a FilterProg and evaluate that instead of walking the Filter tree.
+ * The program differs from the tree walk in three ways:
+ * - the components of each AND/OR are ordered cheapest first, so that
+ *   the short-circuit case is reached with as little work as possible;
+ * - the first matching attribute of each distinct description is
+ *   looked up at most once per entry and shared among components;
+ * - all components tested against an entry share one ACL state, as
+ *   send_search_entry() does for the attributes it returns.
+ * The result is the same as test_filter()'s: when no component decides
+ * the outcome, the code kept is that of the last undecided component
+ * in filter order, not evaluation order.
+ */
+
+typedef struct FilterInsn {
+	Filter		*fi_f;
+	int		fi_end;		/* AND/OR/NOT: index past the last child */
+	int		fi_pos;		/* position among the siblings in the filter */
+	int		fi_slot;	/* leaves: attribute slot, or -1 */
+} FilterInsn;
+
+typedef struct FilterFrame {
+	int		ff_insn;
+	int		ff_rc;
+	int		ff_pos;
+} FilterFrame;
+
+struct FilterProg {
+	int		fp_ninsn;
+	int		fp_nslots;
+	FilterInsn	*fp_insn;
+	AttributeDescription **fp_desc;
+	Attribute	**fp_attr;
+	FilterFrame	*fp_stack;
+	char		*fp_found;
+};
+
+static AttributeDescription *
+filter_prog_desc( Filter *f )
+{
+	if ( f->f_choice & SLAPD_FILTER_UNDEFINED )
+		return NULL;
+
+	switch ( f->f_choice ) {
+	case LDAP_FILTER_EQUALITY:
+	case LDAP_FILTER_GE:
+	case LDAP_FILTER_LE:
+	case LDAP_FILTER_APPROX:
+		return f->f_av_desc;
+	case LDAP_FILTER_SUBSTRINGS:
+		return f->f_sub_desc;
+	case LDAP_FILTER_PRESENT:
+		return f->f_desc;
+	case LDAP_FILTER_EXT:
+		return f->f_mr_desc;
+	}
+	return NULL;
+}
+
+/* rough relative cost of testing a component against an entry */
+static int
+filter_prog_cost( Filter *f )
+{
+	AttributeDescription *ad;
+
+	if ( f->f_choice & SLAPD_FILTER_UNDEFINED )
+		return 0;
+
+	ad = filter_prog_desc( f );
+	if ( ad == slap_schema.si_ad_hasSubordinates ) {
+		/* may have to ask the backend */
+		return 7;
+	}
+
+	switch ( f->f_choice ) {
+	case SLAPD_FILTER_COMPUTED:
+		return 0;
+	case LDAP_FILTER_PRESENT:
+		return 1;
+	case LDAP_FILTER_EQUALITY:
+		/* usually implied by the candidate list, so seldom decisive */
+		return ad == slap_schema.si_ad_objectClass ? 3 : 2;
+	case LDAP_FILTER_GE:
+	case LDAP_FILTER_LE:
+		return 3;
+	case LDAP_FILTER_APPROX:
+		return 4;
+	case LDAP_FILTER_SUBSTRINGS:
+		return 5;
+	case LDAP_FILTER_EXT:
+		return 6;
+	}
+	return 8;
+}
+
+static void
+filter_prog_size( Filter *f, int depth, int *ninsn, int *maxdepth )
+{
+	(*ninsn)++;
+	if ( f->f_choice & SLAPD_FILTER_UNDEFINED )
+		return;
+
+	switch ( f->f_choice ) {
+	case LDAP_FILTER_AND:
+	case LDAP_FILTER_OR:
+	case LDAP_FILTER_NOT:
+		if ( depth + 1 > *maxdepth )
+			*maxdepth = depth + 1;
+		for ( f = f->f_list; f != NULL; f = f->f_next )
+			filter_prog_size( f, depth + 1, ninsn, maxdepth );
+		break;
+	}
+}
+
+static void
+filter_prog_emit( Operation *op, FilterProg *fp, Filter *f, int pos )
+{
+	FilterInsn *fi = &fp->fp_insn[fp->fp_ninsn++];
+	AttributeDescription *ad;
+	int i;
+
+	fi->fi_f = f;
+	fi->fi_pos = pos;
+	fi->fi_slot = -1;
+	fi->fi_end = 0;
+
+	if ( f->f_choice & SLAPD_FILTER_UNDEFINED )
+		return;
+
+	switch ( f->f_choice ) {
+	case LDAP_FILTER_AND:
+	case LDAP_FILTER_OR: {
+		Filter *sf, **kids;
+		int *cost, n, j;
+
+		for ( n = 0, sf = f->f_list; sf != NULL; sf = sf->f_next )
+			n++;
+		kids = op->o_tmpalloc( n * ( sizeof(Filter *) + sizeof(int) ),
+			op->o_tmpmemctx );
+		cost = (int *)( kids + n );
+		for ( i = 0, sf = f->f_list; sf != NULL; sf = sf->f_next, i++ ) {
+			kids[i] = sf;
+			cost[i] = filter_prog_cost( sf );
+		}
+
+		/* stable, so equal costs keep their order in the filter */
+		for ( i = 0; i < n; i++ ) {
+			int best = -1;
+
+			for ( j = 0; j < n; j++ ) {
+				if ( kids[j] != NULL &&
+					( best < 0 || cost[j] < cost[best] ))
+					best = j;
+			}
+			filter_prog_emit( op, fp, kids[best], best );
+			kids[best] = NULL;
+		}
+		op->o_tmpfree( kids, op->o_tmpmemctx );
+		} break;
+
+	case LDAP_FILTER_NOT:
+		filter_prog_emit( op, fp, f->f_not, 0 );
+		break;
+
+	default:
+		ad = filter_prog_desc( f );
+		if ( ad == NULL )
+			return;
+		for ( i = 0; i < fp->fp_nslots; i++ ) {
+			if ( fp->fp_desc[i] == ad )
+				break;
+		}
+		if ( i == fp->fp_nslots )
+			fp->fp_desc[fp->fp_nslots++] = ad;
+		fi->fi_slot = i;
+		return;
+	}
+
+	fi->fi_end = fp->fp_ninsn;
+}
+
+/*
+ * filter_compile - flatten a filter for repeated use by filter_prog_test().
+ * The program is allocated with op->o_tmpalloc, references f and may
+ * not outlive either of them; it must not be shared between threads.
+ */
+FilterProg *
+filter_compile( Operation *op, Filter *f )
+{
+	FilterProg *fp;
+	int ninsn = 0, depth = 0;
+	size_t len;
+
+	filter_prog_size( f, 0, &ninsn, &depth );
+
+	len = sizeof(FilterProg) + ninsn * ( sizeof(FilterInsn) +
+		sizeof(AttributeDescription *) + sizeof(Attribute *) + 1 ) +
+		depth * sizeof(FilterFrame);
+	fp = op->o_tmpcalloc( 1, len, op->o_tmpmemctx );
+	/* pointer-aligned arrays first, the int-only stack and bytes last */
+	fp->fp_insn = (FilterInsn *)( fp + 1 );
+	fp->fp_desc = (AttributeDescription **)( fp->fp_insn + ninsn );
+	fp->fp_attr = (Attribute **)( fp->fp_desc + ninsn );
+	fp->fp_stack = (FilterFrame *)( fp->fp_attr + ninsn );
+	fp->fp_found = (char *)( fp->fp_stack + depth );
+
+	filter_prog_emit( op, fp, f, 0 );
+	assert( fp->fp_ninsn == ninsn );
+
+	return fp;
+}
+
+void
+filter_prog_free( Operation *op, FilterProg *fp )
+{
+	op->o_tmpfree( fp, op->o_tmpmemctx );
+}
+
+static int
+filter_prog_leaf(
+	Operation	*op,
+	Entry	*e,
+	FilterProg	*fp,
+	FilterInsn	*fi,
+	AccessControlState *state )
+{
+	Filter *f = fi->fi_f;
+	Attribute *a = NULL;
+
+	if ( f->f_choice & SLAPD_FILTER_UNDEFINED )
+		return SLAPD_COMPARE_UNDEFINED;
+
+	if ( fi->fi_slot >= 0 ) {
+		if ( !fp->fp_found[fi->fi_slot] ) {
+			fp->fp_attr[fi->fi_slot] = entry_attrs_find( e,
+				fp->fp_desc[fi->fi_slot] );
+			fp->fp_found[fi->fi_slot] = 1;
+		}
+		a = fp->fp_attr[fi->fi_slot];
+	}
+
+	switch ( f->f_choice ) {
+	case SLAPD_FILTER_COMPUTED:
+		return f->f_result;
+
+	case LDAP_FILTER_EQUALITY:
+	case LDAP_FILTER_GE:
+	case LDAP_FILTER_LE:
+	case LDAP_FILTER_APPROX:
+		return test_ava_filter( op, e, f->f_ava, f->f_choice, state, a );
+
+	case LDAP_FILTER_SUBSTRINGS:
+		return test_substrings_filter( op, e, f, state, a );
+
+	case LDAP_FILTER_PRESENT:
+		return test_presence_filter( op, e, f->f_desc, state, a );
+
+	case LDAP_FILTER_EXT:
+		return test_mra_filter( op, e, f->f_mra, state, a );
+	}
+
+	Debug( LDAP_DEBUG_ANY, "    unknown filter type %lu\n",
+		f->f_choice );
+	return LDAP_PROTOCOL_ERROR;
+}
+
+/*
+ * filter_prog_test - test a compiled filter against a single entry.
+ * returns the same as test_filter() would for the source filter.
+ */
+int
+filter_prog_test(
+	Operation	*op,
+	Entry	*e,
+	FilterProg	*fp )
+{
+	AccessControlState acl_state = ACL_STATE_INIT;
+	FilterFrame *ff;
+	FilterInsn *fi;
+	int pc = 0, sp = 0, rc, pos;
+
+	Debug( LDAP_DEBUG_FILTER, "=> filter_prog_test\n" );
+
+	memset( fp->fp_found, 0, fp->fp_nslots );
+
+	for (;;) {
+		fi = &fp->fp_insn[pc];
+
+		switch ( fi->fi_f->f_choice ) {
+		case LDAP_FILTER_AND:
+		case LDAP_FILTER_OR:
+		case LDAP_FILTER_NOT:
+			ff = &fp->fp_stack[sp++];
+			ff->ff_insn = pc;
+			ff->ff_rc = fi->fi_f->f_choice == LDAP_FILTER_OR ?
+				LDAP_COMPARE_FALSE : LDAP_COMPARE_TRUE;
+			ff->ff_pos = -1;
+			pc++;
+			if ( pc < fi->fi_end )
+				continue;
+			/* empty AND or OR */
+			sp--;
+			rc = ff->ff_rc;
+			break;
+
+		default:
+			rc = filter_prog_leaf( op, e, fp, fi, &acl_state );
+			pc++;
+			break;
+		}
+		pos = fi->fi_pos;
+
+		/* hand the result up until a group still has children to test */
+		while ( sp > 0 ) {
+			ff = &fp->fp_stack[sp - 1];
+			fi = &fp->fp_insn[ff->ff_insn];
+
+			switch ( fi->fi_f->f_choice ) {
+			case LDAP_FILTER_AND:
+				if ( rc == LDAP_COMPARE_FALSE ) {
+					ff->ff_rc = rc;
+					pc = fi->fi_end;
+				} else if ( rc != LDAP_COMPARE_TRUE && pos > ff->ff_pos ) {
+					ff->ff_rc = rc;
+					ff->ff_pos = pos;
+				}
+				break;
+
+			case LDAP_FILTER_OR:
+				if ( rc == LDAP_COMPARE_TRUE ) {
+					ff->ff_rc = rc;
+					pc = fi->fi_end;
+				} else if ( rc != LDAP_COMPARE_FALSE && pos > ff->ff_pos ) {
+					ff->ff_rc = rc;
+					ff->ff_pos = pos;
+				}
+				break;
+
+			case LDAP_FILTER_NOT:
+				if ( rc == LDAP_COMPARE_TRUE )
+					rc = LDAP_COMPARE_FALSE;
+				else if ( rc == LDAP_COMPARE_FALSE )
+					rc = LDAP_COMPARE_TRUE;
+				ff->ff_rc = rc;
+				break;
+			}
+
+			if ( pc < fi->fi_end )
+				break;
+
+			sp--;
+			rc = ff->ff_rc;
+			pos = fi->fi_pos;
+		}
+
+		if ( sp == 0 )
+			break;
+	}
+
+	Debug( LDAP_DEBUG_FILTER, "<= filter_prog_test %d\n", rc );
+	return rc;
+}
@@ -92,6 +92,9 @@ slap_init( int mode, const char *name )
 	ldap_pvt_thread_mutex_init( &slapd_init_mutex );
 	ldap_pvt_thread_cond_init( &slapd_init_cond );
 
+	/* schema loading flushes it */
+	dn_cache_init();
+
 #ifdef SLAPD_MODULES
 	if ( module_init() != 0 ) {
 		slap_debug |= LDAP_DEBUG_NONE;
@@ -142,6 +145,7 @@ slap_init( int mode, const char *name )
 				connection_pool_max, 0, connection_pool_queues);
 
 		slap_counters_init( &slap_counters );
+		slap_group_cache_init();
 
 		ldap_pvt_thread_mutex_init( &slapd_rq.rq_mutex );
 		LDAP_STAILQ_INIT( &slapd_rq.task_list );
@@ -268,6 +272,8 @@ int slap_destroy(void)
 	case SLAP_SERVER_MODE:
 	case SLAP_TOOL_MODE:
 		slap_counters_destroy( &slap_counters );
+		slap_group_cache_destroy();
+		dn_cache_destroy();
 		break;
 
 	default:
@@ -307,6 +313,10 @@ void slap_counters_init( slap_counters_t *sc )
 		ldap_pvt_mp_init( sc->sc_ops_initiated_[ i ] );
 		ldap_pvt_mp_init( sc->sc_ops_completed_[ i ] );
 	}
+
+	ldap_pvt_mp_init( sc->sc_acl_evals );
+	ldap_pvt_mp_init( sc->sc_acl_rules );
+	ldap_pvt_mp_init( sc->sc_acl_skipped );
 }
 
 void slap_counters_destroy( slap_counters_t *sc )
@@ -326,5 +336,9 @@ void slap_counters_destroy( slap_counters_t *sc )
 		ldap_pvt_mp_clear( sc->sc_ops_initiated_[ i ] );
 		ldap_pvt_mp_clear( sc->sc_ops_completed_[ i ] );
 	}
+
+	ldap_pvt_mp_clear( sc->sc_acl_evals );
+	ldap_pvt_mp_clear( sc->sc_acl_rules );
+	ldap_pvt_mp_clear( sc->sc_acl_skipped );
 }
 
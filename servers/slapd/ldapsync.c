@@ -262,6 +262,29 @@ slap_insert_csn_sids(
 	ber_dupbv( &ck->ctxcsn[i], csn );
 }
 
+/* Find sid in a CSN vector sorted by sid. Returns its index if present,
+ * otherwise the position slap_insert_csn_sids() should insert it at.
+ */
+int
+slap_csn_sid_slot(
+	int *sids,
+	int numcsns,
+	int sid
+)
+{
+	int lo = 0, hi = numcsns;
+
+	while ( lo < hi ) {
+		int mid = ( lo + hi ) >> 1;
+
+		if ( sids[mid] < sid )
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
 int
 slap_parse_sync_cookie(
 	struct sync_cookie *cookie,
@@ -84,7 +84,7 @@ int is_entry_objectclass(
 	/*
 	 * find objectClass attribute
 	 */
-	attr = attr_find( e->e_attrs, slap_schema.si_ad_objectClass );
+	attr = entry_attr_find( e, slap_schema.si_ad_objectClass );
 	if ( attr == NULL ) {
 		/* no objectClass attribute */
 		Debug( LDAP_DEBUG_ANY, "is_entry_objectclass(\"%s\", \"%s\") "
@@ -134,7 +134,7 @@ struct oindexrec {
 };
 
 static Avlnode	*oc_index = NULL;
-static Avlnode	*oc_cache = NULL;
+static SchemaHash	*oc_hash = NULL;
 static LDAP_STAILQ_HEAD(OCList, ObjectClass) oc_list
 	= LDAP_STAILQ_HEAD_INITIALIZER(oc_list);
 
@@ -151,18 +151,6 @@ oc_index_cmp(
 	return strcasecmp( oir1->oir_name.bv_val, oir2->oir_name.bv_val );
 }
 
-static int
-oc_index_name_cmp(
-	const void *v_name,
-	const void *v_oir )
-{
-	const struct berval    *name = v_name;
-	const struct oindexrec *oir  = v_oir;
-	int i = name->bv_len - oir->oir_name.bv_len;
-	if (i) return i;
-	return strncasecmp( name->bv_val, oir->oir_name.bv_val, name->bv_len );
-}
-
 ObjectClass *
 oc_find( const char *ocname )
 {
@@ -179,17 +167,10 @@ oc_bvfind( struct berval *ocname )
 {
 	struct oindexrec	*oir;
 
-	if ( oc_cache ) {
-		oir = ldap_avl_find( oc_cache, ocname, oc_index_name_cmp );
-		if ( oir ) return oir->oir_oc;
-	}
-	oir = ldap_avl_find( oc_index, ocname, oc_index_name_cmp );
+	/* oir_name is the first member of the record */
+	oir = (struct oindexrec *)schema_hash_find( oc_hash, ocname );
 
 	if ( oir != NULL ) {
-		if ( at_oc_cache ) {
-			ldap_avl_insert( &oc_cache, (caddr_t) oir,
-				oc_index_cmp, ldap_avl_dup_error );
-		}
 		return( oir->oir_oc );
 	}
 
@@ -410,6 +391,7 @@ oc_delete_names( ObjectClass *oc )
 		oir = (struct oindexrec *)ldap_avl_delete( &oc_index,
 			(caddr_t)&tmpoir, oc_index_cmp );
 		assert( oir != NULL );
+		schema_hash_delete( &oc_hash, &oir->oir_name );
 		ldap_memfree( oir );
 		names++;
 	}
@@ -473,6 +455,7 @@ oc_destroy( void )
 	}
 	
 	ldap_avl_free( oc_index, oc_destroy_one );
+	schema_hash_free( &oc_hash );
 
 	while( !LDAP_STAILQ_EMPTY(&oc_undef_list) ) {
 		o = LDAP_STAILQ_FIRST(&oc_undef_list);
@@ -633,6 +616,8 @@ oc_insert(
 				ldap_memfree( oir );
 				return rc;
 			}
+		} else {
+			schema_hash_insert( &oc_hash, &oir->oir_name );
 		}
 
 		/* FIX: temporal consistency check */
@@ -672,6 +657,7 @@ oc_insert(
 					oir = (struct oindexrec *)ldap_avl_delete( &oc_index,
 						(caddr_t)&tmpoir, oc_index_cmp );
 					assert( oir != NULL );
+					schema_hash_delete( &oc_hash, &oir->oir_name );
 					ldap_memfree( oir );
 				}
 
@@ -683,11 +669,13 @@ oc_insert(
 					oir = (struct oindexrec *)ldap_avl_delete( &oc_index,
 						(caddr_t)&tmpoir, oc_index_cmp );
 					assert( oir != NULL );
+					schema_hash_delete( &oc_hash, &oir->oir_name );
 					ldap_memfree( oir );
 				}
 
 				return rc;
 			}
+			schema_hash_insert( &oc_hash, &oir->oir_name );
 
 			/* FIX: temporal consistency check */
 			assert( oc_bvfind(&oir->oir_name) != NULL );
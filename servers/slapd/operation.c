@@ -41,10 +41,30 @@ static ldap_pvt_thread_mutex_t	slap_op_mutex;
 static time_t last_time;
 static int last_incr;
 
+/*
+ * Operations are carved out of slabs of cache-line aligned buffers
+ * and are only returned to malloc at shutdown. Each thread keeps a
+ * short free list of its own; operations that overflow it, or that are
+ * freed without a thread context, go to a shared pool. Since most
+ * operations are allocated by the listener and freed by a worker,
+ * the shared pool is what keeps the listener from hitting malloc.
+ */
+#define SLAP_OP_SLAB	16
+#define SLAP_OP_ALIGN	64
+#define SLAP_OP_SIZE	\
+	(( sizeof( OperationBuffer ) + SLAP_OP_ALIGN - 1 ) & ~( SLAP_OP_ALIGN - 1 ))
+
+static ldap_pvt_thread_mutex_t	slap_op_pool_mutex;
+static void *slap_op_slabs;
+static Operation *slap_op_pool;
+static slap_op_pool_stats_t slap_op_stats;
+static int slap_op_pool_closed;
+
 void slap_op_init(void)
 {
 	struct timeval tv;
 	ldap_pvt_thread_mutex_init( &slap_op_mutex );
+	ldap_pvt_thread_mutex_init( &slap_op_pool_mutex );
 	gettimeofday( &tv, NULL );
 	last_time = tv.tv_sec;
 	last_incr = tv.tv_usec;
@@ -52,17 +72,95 @@ void slap_op_init(void)
 
 void slap_op_destroy(void)
 {
+	void *slab, *next;
+
+	ldap_pvt_thread_mutex_lock( &slap_op_pool_mutex );
+	for ( slab = slap_op_slabs; slab; slab = next ) {
+		next = *(void **)slab;
+		ch_free( slab );
+	}
+	slap_op_slabs = NULL;
+	slap_op_pool = NULL;
+	slap_op_pool_closed = 1;
+	ldap_pvt_thread_mutex_unlock( &slap_op_pool_mutex );
+
+	ldap_pvt_thread_mutex_destroy( &slap_op_pool_mutex );
 	ldap_pvt_thread_mutex_destroy( &slap_op_mutex );
 }
 
+/* caller must hold slap_op_pool_mutex */
+static void
+slap_op_pool_put( Operation *op )
+{
+	LDAP_STAILQ_NEXT( op, o_next ) = slap_op_pool;
+	slap_op_pool = op;
+	slap_op_stats.ps_pooled++;
+}
+
+static Operation *
+slap_op_pool_get( void )
+{
+	Operation *op;
+
+	ldap_pvt_thread_mutex_lock( &slap_op_pool_mutex );
+	op = slap_op_pool;
+	if ( op ) {
+		slap_op_pool = LDAP_STAILQ_NEXT( op, o_next );
+		slap_op_stats.ps_pooled--;
+		slap_op_stats.ps_reused++;
+	} else {
+		char *slab, *ptr;
+		int i;
+
+		slab = ch_calloc( 1, sizeof( void * ) + SLAP_OP_ALIGN +
+			SLAP_OP_SLAB * SLAP_OP_SIZE );
+		*(void **)slab = slap_op_slabs;
+		slap_op_slabs = slab;
+
+		ptr = slab + sizeof( void * );
+		ptr += ( SLAP_OP_ALIGN - ( (size_t)ptr & ( SLAP_OP_ALIGN - 1 ))) &
+			( SLAP_OP_ALIGN - 1 );
+		for ( i = 0; i < SLAP_OP_SLAB; i++, ptr += SLAP_OP_SIZE ) {
+			OperationBuffer *opbuf = (OperationBuffer *)ptr;
+
+			opbuf->ob_op.o_hdr = &opbuf->ob_hdr;
+			opbuf->ob_op.o_controls = opbuf->ob_controls;
+			if ( i )
+				slap_op_pool_put( &opbuf->ob_op );
+			else
+				op = &opbuf->ob_op;
+		}
+		slap_op_stats.ps_allocated += SLAP_OP_SLAB;
+	}
+	ldap_pvt_thread_mutex_unlock( &slap_op_pool_mutex );
+
+	LDAP_STAILQ_NEXT( op, o_next ) = NULL;
+	return op;
+}
+
+void
+slap_op_pool_stats( slap_op_pool_stats_t *ps )
+{
+	ldap_pvt_thread_mutex_lock( &slap_op_pool_mutex );
+	*ps = slap_op_stats;
+	ldap_pvt_thread_mutex_unlock( &slap_op_pool_mutex );
+}
+
 static void
 slap_op_q_destroy( void *key, void *data )
 {
 	Operation *op, *op2;
+
+	/* the slabs (and the mutex) are already gone */
+	if ( slap_op_pool_closed )
+		return;
+
+	ldap_pvt_thread_mutex_lock( &slap_op_pool_mutex );
 	for ( op = data; op; op = op2 ) {
 		op2 = LDAP_STAILQ_NEXT( op, o_next );
-		ber_memfree_x( op, NULL );
+		slap_op_pool_put( op );
 	}
+	ldap_pvt_thread_mutex_unlock( &slap_op_pool_mutex );
 }
 
 void
@@ -150,13 +248,16 @@ slap_op_free( Operation *op, void *ctx )
 			if ( op->o_tincr > 10 ) {
 				ldap_pvt_thread_pool_setkey( ctx, (void *)slap_op_free,
 					op2, slap_op_q_destroy, NULL, NULL );
-				ber_memfree_x( op, NULL );
+				ctx = NULL;
 			}
 		} else {
 			op->o_tincr = 1;
 		}
-	} else {
-		ber_memfree_x( op, NULL );
+	}
+	if ( !ctx ) {
+		ldap_pvt_thread_mutex_lock( &slap_op_pool_mutex );
+		slap_op_pool_put( op );
+		ldap_pvt_thread_mutex_unlock( &slap_op_pool_mutex );
 	}
 }
 
@@ -201,9 +302,9 @@ slap_op_alloc(
 		}
 	}
 	if (!op) {
-		op = (Operation *) ch_calloc( 1, sizeof(OperationBuffer) );
-		op->o_hdr = &((OperationBuffer *) op)->ob_hdr;
-		op->o_controls = ((OperationBuffer *) op)->ob_controls;
+		op = slap_op_pool_get();
+		op->o_abandon = 0;
+		op->o_cancel = 0;
 	}
 
 	op->o_ber = ber;
@@ -33,6 +33,8 @@
 #include "lutil.h"
 #include "ldap_rq.h"
 
+#include "../back-monitor/back-monitor.h"
+
 #define LOG_OP_ADD	0x001
 #define LOG_OP_DELETE	0x002
 #define	LOG_OP_MODIFY	0x004
@@ -71,6 +73,12 @@ typedef struct log_info {
 	slap_mask_t li_ops;
 	int li_age;
 	int li_cycle;
+	int li_purgebatch;	/* max entries deleted per purge run */
+	unsigned long li_purged;	/* purge statistics */
+	unsigned long li_purgeruns;
+	unsigned long li_purgebacklog;
+	struct berval li_monitor_ndn;
+	void *li_monitor_cb;
 	struct re_s *li_task;
 	Filter *li_oldf;
 	Entry *li_old;
@@ -93,7 +101,8 @@ enum {
 	LOG_SUCCESS,
 	LOG_OLD,
 	LOG_OLDATTR,
-	LOG_BASE
+	LOG_BASE,
+	LOG_PURGEBATCH
 };
 
 static ConfigTable log_cfats[] = {
@@ -134,6 +143,11 @@ static ConfigTable log_cfats[] = {
 			"DESC 'Operation types to log under a specific branch' "
 			"EQUALITY caseIgnoreMatch "
 			"SYNTAX OMsDirectoryString )", NULL, NULL },
+	{ "logpurgebatch", "entries", 2, 2, 0, ARG_MAGIC|ARG_INT|LOG_PURGEBATCH,
+		log_cf_gen, "( OLcfgOvAt:4.8 NAME 'olcAccessLogPurgeBatch' "
+			"DESC 'Max log entries deleted per purge run' "
+			"EQUALITY integerMatch "
+			"SYNTAX OMsInteger SINGLE-VALUE )", NULL, NULL },
 	{ NULL }
 };
 
@@ -144,7 +158,8 @@ static ConfigOCs log_cfocs[] = {
 		"SUP olcOverlayConfig "
 		"MUST olcAccessLogDB "
 		"MAY ( olcAccessLogOps $ olcAccessLogPurge $ olcAccessLogSuccess $ "
-			"olcAccessLogOld $ olcAccessLogOldAttr $ olcAccessLogBase ) )",
+			"olcAccessLogOld $ olcAccessLogOldAttr $ olcAccessLogBase $ "
+			"olcAccessLogPurgeBatch ) )",
 			Cft_Overlay, log_cfats },
 	{ NULL }
 };
@@ -617,6 +632,7 @@ typedef struct purge_data {
 	int slots;
 	int used;
 	int mincsn_updated;
+	int more;
 	BerVarray dn;
 	BerVarray ndn;
 } purge_data;
@@ -632,6 +648,14 @@ log_old_lookup( Operation *op, SlapReply *rs )
 
 	if ( slapd_shutdown ) return 0;
 
+	/* Batch is full, leave the rest for the next run. The search
+	 * returns log entries in ID order, which is reqStart order, so
+	 * the oldest ones are always taken first. */
+	if ( li->li_purgebatch && pd->used >= li->li_purgebatch ) {
+		pd->more = 1;
+		return LDAP_SIZELIMIT_EXCEEDED;
+	}
+
 	/* Update minCSN */
 	a = attr_find( rs->sr_entry->e_attrs,
 		slap_schema.si_ad_entryCSN );
@@ -642,9 +666,7 @@ log_old_lookup( Operation *op, SlapReply *rs )
 		/* Find the correct sid */
 		sid = slap_parse_csn_sid( &a->a_nvals[0] );
 		ldap_pvt_thread_mutex_lock( &li->li_log_mutex );
-		for ( i=0; i < li->li_numcsns; i++ ) {
-			if ( sid <= li->li_sids[i] ) break;
-		}
+		i = slap_csn_sid_slot( li->li_sids, li->li_numcsns, sid );
 		if ( i >= li->li_numcsns || sid != li->li_sids[i] ) {
 			Debug( LDAP_DEBUG_ANY, "log_old_lookup: "
 					"csn=%s with sid not in minCSN set!\n",
@@ -691,6 +713,7 @@ accesslog_purge( void *ctx, void *arg )
 	char timebuf[LDAP_LUTIL_GENTIME_BUFSIZE];
 	char csnbuf[LDAP_PVT_CSNSTR_BUFSIZE];
 	time_t old = slap_get_time();
+	int more = 0;
 
 	connection_fake_init( &conn, &opbuf, ctx );
 	op = &opbuf.ob_op;
@@ -726,6 +749,7 @@ accesslog_purge( void *ctx, void *arg )
 
 	op->o_bd->be_search( op, &rs );
 	op->o_tmpfree( op->ors_filterstr.bv_val, op->o_tmpmemctx );
+	more = pd.more;
 
 	if ( pd.used ) {
 		int i;
@@ -769,7 +793,8 @@ accesslog_purge( void *ctx, void *arg )
 			op->o_req_ndn = pd.ndn[i];
 			if ( !slapd_shutdown ) {
 				rs_reinit( &rs, REP_RESULT );
-				op->o_bd->be_delete( op, &rs );
+				if ( op->o_bd->be_delete( op, &rs ) == LDAP_SUCCESS )
+					li->li_purged++;
 			}
 			ch_free( pd.ndn[i].bv_val );
 			ch_free( pd.dn[i].bv_val );
@@ -779,10 +804,27 @@ accesslog_purge( void *ctx, void *arg )
 		ch_free( pd.dn );
 	}
 
+	li->li_purgeruns++;
+	if ( more )
+		li->li_purgebacklog++;
+	else
+		li->li_purgebacklog = 0;
+
 	ldap_pvt_thread_mutex_lock( &slapd_rq.rq_mutex );
 	ldap_pvt_runqueue_stoptask( &slapd_rq, rtask );
+	/* Come back for the rest of the backlog right away, after any
+	 * other task that is due has had its turn */
+	more = more && !slapd_shutdown && li->li_task == rtask;
+	if ( more ) {
+		rtask->interval.tv_sec = 0;
+		ldap_pvt_runqueue_resched( &slapd_rq, rtask, 0 );
+		rtask->interval.tv_sec = li->li_cycle;
+	}
 	ldap_pvt_thread_mutex_unlock( &slapd_rq.rq_mutex );
 
+	if ( more )
+		slap_wake_listener();
+
 	return NULL;
 }
 
@@ -838,6 +880,12 @@ log_cf_gen(ConfigArgs *c)
 			else
 				rc = 1;
 			break;
+		case LOG_PURGEBATCH:
+			if ( li->li_purgebatch )
+				c->value_int = li->li_purgebatch;
+			else
+				rc = 1;
+			break;
 		case LOG_OLD:
 			if ( li->li_oldf ) {
 				filter2bv( li->li_oldf, &agebv );
@@ -898,6 +946,9 @@ log_cf_gen(ConfigArgs *c)
 		case LOG_SUCCESS:
 			li->li_success = 0;
 			break;
+		case LOG_PURGEBATCH:
+			li->li_purgebatch = 0;
+			break;
 		case LOG_OLD:
 			if ( li->li_oldf ) {
 				filter_free( li->li_oldf );
@@ -1005,6 +1056,16 @@ log_cf_gen(ConfigArgs *c)
 		case LOG_SUCCESS:
 			li->li_success = c->value_int;
 			break;
+		case LOG_PURGEBATCH:
+			if ( c->value_int < 0 ) {
+				snprintf( c->cr_msg, sizeof( c->cr_msg ),
+					"<%s> invalid batch size %d", c->argv[0], c->value_int );
+				Debug( LDAP_DEBUG_ANY, "%s: %s\n", c->log, c->cr_msg );
+				rc = 1;
+				break;
+			}
+			li->li_purgebatch = c->value_int;
+			break;
 		case LOG_OLD:
 			li->li_oldf = str2filter( c->argv[1] );
 			if ( !li->li_oldf ) {
@@ -1957,9 +2018,7 @@ static int accesslog_response(Operation *op, SlapReply *rs) {
 		Modifications mod;
 		int i, sid = slap_parse_csn_sid( &op->o_csn );
 
-		for ( i=0; i < li->li_numcsns; i++ ) {
-			if ( sid <= li->li_sids[i] ) break;
-		}
+		i = slap_csn_sid_slot( li->li_sids, li->li_numcsns, sid );
 		if ( i >= li->li_numcsns || sid != li->li_sids[i] ) {
 			/* SID not in minCSN set, add */
 			struct berval bv[2];
@@ -2248,6 +2307,315 @@ accesslog_operational( Operation *op, SlapReply *rs )
 
 static slap_overinst accesslog;
 
+static ObjectClass		*oc_olmAccessLog;
+
+static AttributeDescription	*ad_olmAccessLogPurged,
+	*ad_olmAccessLogPurgeRuns, *ad_olmAccessLogPurgeBacklog;
+
+static struct {
+	char			*name;
+	char			*oid;
+}		s_oid[] = {
+	{ "olmAccessLogAttributes",		"olmOverlayAttributes:3" },
+	{ "olmAccessLogObjectClasses",		"olmOverlayObjectClasses:3" },
+
+	{ NULL }
+};
+
+static struct {
+	char			*desc;
+	AttributeDescription	**ad;
+}		s_at[] = {
+	{ "( olmAccessLogAttributes:1 "
+		"NAME ( 'olmAccessLogPurged' ) "
+		"DESC 'Number of log entries deleted by logpurge' "
+		"SUP monitorCounter "
+		"NO-USER-MODIFICATION "
+		"USAGE dSAOperation )",
+		&ad_olmAccessLogPurged },
+
+	{ "( olmAccessLogAttributes:2 "
+		"NAME ( 'olmAccessLogPurgeRuns' ) "
+		"DESC 'Number of logpurge runs' "
+		"SUP monitorCounter "
+		"NO-USER-MODIFICATION "
+		"USAGE dSAOperation )",
+		&ad_olmAccessLogPurgeRuns },
+
+	{ "( olmAccessLogAttributes:3 "
+		"NAME ( 'olmAccessLogPurgeBacklog' ) "
+		"DESC 'Number of consecutive logpurge runs that hit logpurgebatch' "
+		"SUP monitorCounter "
+		"NO-USER-MODIFICATION "
+		"USAGE dSAOperation )",
+		&ad_olmAccessLogPurgeBacklog },
+
+	{ NULL }
+};
+
+static struct {
+	char		*desc;
+	ObjectClass	**oc;
+}		s_oc[] = {
+	/* augments an existing object, so it must be AUXILIARY */
+	{ "( olmAccessLogObjectClasses:1 "
+		"NAME ( 'olmAccessLog' ) "
+		"SUP top AUXILIARY "
+		"MAY ( "
+			"olmAccessLogPurged "
+			"$ olmAccessLogPurgeRuns "
+			"$ olmAccessLogPurgeBacklog "
+			") )",
+		&oc_olmAccessLog },
+
+	{ NULL }
+};
+
+static void
+accesslog_monitor_set( Entry *e, AttributeDescription *ad, unsigned long n )
+{
+	Attribute *a;
+	char buf[ LDAP_PVT_INTTYPE_CHARS(unsigned long) ];
+	struct berval bv;
+
+	a = attr_find( e->e_attrs, ad );
+	assert( a != NULL );
+	bv.bv_val = buf;
+	bv.bv_len = snprintf( buf, sizeof( buf ), "%lu", n );
+	ber_bvreplace( &a->a_vals[ 0 ], &bv );
+}
+
+static int
+accesslog_monitor_update(
+	Operation	*op,
+	SlapReply	*rs,
+	Entry		*e,
+	void		*priv )
+{
+	log_info	*li = (log_info *) priv;
+
+	accesslog_monitor_set( e, ad_olmAccessLogPurged, li->li_purged );
+	accesslog_monitor_set( e, ad_olmAccessLogPurgeRuns, li->li_purgeruns );
+	accesslog_monitor_set( e, ad_olmAccessLogPurgeBacklog, li->li_purgebacklog );
+
+	return SLAP_CB_CONTINUE;
+}
+
+static int
+accesslog_monitor_free(
+	Entry		*e,
+	void		**priv )
+{
+	struct berval	values[ 2 ];
+	Modification	mod = { 0 };
+
+	const char	*text;
+	char		textbuf[ SLAP_TEXT_BUFLEN ];
+
+	int		i;
+
+	/* NOTE: if slap_shutdown != 0, priv might have already been freed */
+	*priv = NULL;
+
+	/* Remove objectClass */
+	mod.sm_op = LDAP_MOD_DELETE;
+	mod.sm_desc = slap_schema.si_ad_objectClass;
+	mod.sm_values = values;
+	mod.sm_numvals = 1;
+	values[ 0 ] = oc_olmAccessLog->soc_cname;
+	BER_BVZERO( &values[ 1 ] );
+
+	modify_delete_values( e, &mod, 1, &text,
+		textbuf, sizeof( textbuf ) );
+	/* don't care too much about return code... */
+
+	/* remove attrs */
+	mod.sm_values = NULL;
+	mod.sm_numvals = 0;
+	for ( i = 0; s_at[ i ].desc != NULL; i++ ) {
+		mod.sm_desc = *s_at[ i ].ad;
+		modify_delete_values( e, &mod, 1, &text,
+			textbuf, sizeof( textbuf ) );
+		/* don't care too much about return code... */
+	}
+
+	return SLAP_CB_CONTINUE;
+}
+
+/*
+ * call from within accesslog_db_init()
+ */
+static int
+accesslog_monitor_initialize( void )
+{
+	int		i, code;
+	ConfigArgs c;
+	char	*argv[ 3 ];
+
+	static int	accesslog_monitor_initialized = 0;
+
+	/* set to 0 when successfully initialized; otherwise, remember failure */
+	static int	accesslog_monitor_initialized_failure = 1;
+
+	if ( accesslog_monitor_initialized++ ) {
+		return accesslog_monitor_initialized_failure;
+	}
+
+	if ( backend_info( "monitor" ) == NULL ) {
+		return -1;
+	}
+
+	argv[ 0 ] = "accesslog monitor";
+	c.argv = argv;
+	c.argc = 3;
+	c.fname = argv[0];
+
+	for ( i = 0; s_oid[ i ].name; i++ ) {
+		c.lineno = i;
+		argv[ 1 ] = s_oid[ i ].name;
+		argv[ 2 ] = s_oid[ i ].oid;
+
+		if ( parse_oidm( &c, 0, NULL ) != 0 ) {
+			Debug( LDAP_DEBUG_ANY, "accesslog_monitor_initialize: "
+				"unable to add objectIdentifier \"%s=%s\"\n",
+				s_oid[ i ].name, s_oid[ i ].oid );
+			return 2;
+		}
+	}
+
+	for ( i = 0; s_at[ i ].desc != NULL; i++ ) {
+		code = register_at( s_at[ i ].desc, s_at[ i ].ad, 1 );
+		if ( code != LDAP_SUCCESS ) {
+			Debug( LDAP_DEBUG_ANY, "accesslog_monitor_initialize: "
+				"register_at failed for attributeType (%s)\n",
+				s_at[ i ].desc );
+			return 3;
+
+		} else {
+			(*s_at[ i ].ad)->ad_type->sat_flags |= SLAP_AT_HIDE;
+		}
+	}
+
+	for ( i = 0; s_oc[ i ].desc != NULL; i++ ) {
+		code = register_oc( s_oc[ i ].desc, s_oc[ i ].oc, 1 );
+		if ( code != LDAP_SUCCESS ) {
+			Debug( LDAP_DEBUG_ANY, "accesslog_monitor_initialize: "
+				"register_oc failed for objectClass (%s)\n",
+				s_oc[ i ].desc );
+			return 4;
+
+		} else {
+			(*s_oc[ i ].oc)->soc_flags |= SLAP_OC_HIDE;
+		}
+	}
+
+	return ( accesslog_monitor_initialized_failure = LDAP_SUCCESS );
+}
+
+static int
+accesslog_monitor_db_open( BackendDB *be )
+{
+	slap_overinst		*on = (slap_overinst *)be->bd_info;
+	log_info		*li = on->on_bi.bi_private;
+	Attribute		*a, *next;
+	monitor_callback_t	*cb = NULL;
+	int			i, rc = 0;
+	BackendInfo		*mi;
+	monitor_extra_t		*mbe;
+
+	/* schema registration failed, or monitoring is off */
+	if ( !oc_olmAccessLog || !SLAP_DBMONITORING( be ) ) {
+		return 0;
+	}
+
+	mi = backend_info( "monitor" );
+	if ( !mi || !mi->bi_extra ) {
+		return 0;
+	}
+	mbe = mi->bi_extra;
+
+	/* don't bother if monitor is not configured */
+	if ( !mbe->is_configured() ) {
+		return 0;
+	}
+
+	/* alloc as many as required (plus 1 for objectClass) */
+	for ( i = 0; s_at[ i ].desc != NULL; i++ )
+		;
+	a = attrs_alloc( 1 + i );
+	if ( a == NULL ) {
+		rc = 1;
+		goto cleanup;
+	}
+
+	a->a_desc = slap_schema.si_ad_objectClass;
+	attr_valadd( a, &oc_olmAccessLog->soc_cname, NULL, 1 );
+	next = a->a_next;
+
+	for ( i = 0; s_at[ i ].desc != NULL; i++ ) {
+		struct berval	bv = BER_BVC( "0" );
+
+		next->a_desc = *s_at[ i ].ad;
+		attr_valadd( next, &bv, NULL, 1 );
+		next = next->a_next;
+	}
+
+	cb = ch_calloc( sizeof( monitor_callback_t ), 1 );
+	cb->mc_update = accesslog_monitor_update;
+	cb->mc_free = accesslog_monitor_free;
+	cb->mc_private = (void *)li;
+
+	/* make sure the database is registered; then add monitor attributes */
+	BER_BVZERO( &li->li_monitor_ndn );
+	rc = mbe->register_database( be, &li->li_monitor_ndn );
+	if ( rc == 0 ) {
+		rc = mbe->register_entry_attrs( &li->li_monitor_ndn, a, cb,
+			NULL, -1, NULL );
+	}
+
+cleanup:;
+	if ( rc != 0 ) {
+		if ( cb != NULL ) {
+			ch_free( cb );
+			cb = NULL;
+		}
+	}
+
+	/* store for cleanup */
+	li->li_monitor_cb = (void *)cb;
+
+	/* we don't need to keep track of the attributes, because
+	 * accesslog_monitor_free() takes care of everything */
+	if ( a != NULL ) {
+		attrs_free( a );
+	}
+
+	return rc;
+}
+
+static int
+accesslog_monitor_db_close( BackendDB *be )
+{
+	slap_overinst		*on = (slap_overinst *)be->bd_info;
+	log_info		*li = on->on_bi.bi_private;
+
+	if ( !BER_BVISNULL( &li->li_monitor_ndn )) {
+		BackendInfo		*mi = backend_info( "monitor" );
+		monitor_extra_t		*mbe;
+
+		if ( mi && mi->bi_extra ) {
+			struct berval dummy = BER_BVNULL;
+			mbe = mi->bi_extra;
+			mbe->unregister_entry_callback( &li->li_monitor_ndn,
+				(monitor_callback_t *)li->li_monitor_cb,
+				&dummy, 0, &dummy );
+		}
+		BER_BVZERO( &li->li_monitor_ndn );
+	}
+
+	return 0;
+}
+
 static int
 accesslog_db_init(
 	BackendDB *be,
@@ -2260,6 +2628,9 @@ accesslog_db_init(
 	on->on_bi.bi_private = li;
 	ldap_pvt_thread_mutex_recursive_init( &li->li_op_rmutex );
 	ldap_pvt_thread_mutex_init( &li->li_log_mutex );
+
+	/* only reports if the underlying database has monitoring on */
+	accesslog_monitor_initialize();
 	return 0;
 }
 
@@ -2481,6 +2852,8 @@ accesslog_db_open(
 		"accesslog_db_root", li->li_db->be_suffix[0].bv_val );
 	ldap_pvt_thread_mutex_unlock( &slapd_rq.rq_mutex );
 
+	accesslog_monitor_db_open( be );
+
 	return 0;
 }
 
@@ -2505,6 +2878,8 @@ accesslog_db_close(
 		ldap_pvt_thread_mutex_unlock( &slapd_rq.rq_mutex );
 	}
 
+	accesslog_monitor_db_close( be );
+
 	return 0;
 }
 
@@ -3311,6 +3311,7 @@ refresh_merge( Operation *op, SlapReply *rs )
 			slap_callback cb = { NULL, slap_null_cb, NULL, NULL };
 
 			ne = *e;
+			ne.e_attrindex = NULL;
 			b = &ne.e_attrs;
 			/* Get a copy of only the attrs we requested */
 			for ( a=e->e_attrs; a; a=a->a_next ) {
@@ -28,6 +28,8 @@
 #include "slap-config.h"
 #include "ldap_rq.h"
 
+#include "../back-monitor/back-monitor.h"
+
 #ifdef LDAP_DEVEL
 #define	CHECK_CSN	1
 #endif
@@ -68,6 +70,17 @@ typedef struct syncres {
 	char s_mode;
 } syncres;
 
+/* An equality assertion required by the filter of one or more
+ * persistent searches, see syncprov_matchops
+ */
+typedef struct syncops_eqkey {
+	AttributeDescription *ek_ad;
+	struct berval	ek_val;		/* normalized assertion value */
+	int		ek_refcnt;
+	int		ek_match;	/* result for the current change */
+	unsigned long	ek_gen;		/* si_matchgen ek_match belongs to */
+} syncops_eqkey;
+
 /* Record of a persistent search */
 typedef struct syncops {
 	struct syncops *s_next;
@@ -75,6 +88,7 @@ typedef struct syncops {
 	struct berval	s_base;		/* ndn of search base */
 	ID		s_eid;		/* entryID of search base */
 	Operation	*s_op;		/* search op */
+	syncops_eqkey	*s_eqkey;	/* indexed part of the filter */
 	int		s_rid;
 	int		s_sid;
 	struct berval s_filterstr;
@@ -161,14 +175,24 @@ typedef struct syncprov_info_t {
 	int		si_numops;	/* number of ops since last checkpoint */
 	int		si_nopres;	/* Skip present phase */
 	int		si_usehint;	/* use reload hint */
+	int		si_batchops;	/* responses sent per task run */
+	int		si_batchtime;	/* time slice per task run, in msecs */
 	int		si_active;	/* True if there are active mods */
 	int		si_dirty;	/* True if the context is dirty, i.e changes
 						 * have been made without updating the csn. */
 	time_t	si_chklast;	/* time of last checkpoint */
 	Avlnode	*si_mods;	/* entries being modified */
 	sessionlog	*si_logs;
+	TAvlnode	*si_eqkeys;	/* psearch filters, by equality assertion */
+	unsigned long	si_matchgen;	/* number of syncprov_matchops passes */
+	unsigned long	si_nmatchtests;	/* psearch filters evaluated */
+	unsigned long	si_nmatchskips;	/* evaluations avoided by si_eqkeys */
+	unsigned long	si_nmatches;	/* psearches that matched a change */
+	struct berval	si_monitor_ndn;
+	void		*si_monitor_cb;
 	ldap_pvt_thread_rdwr_t	si_csn_rwlock;
 	ldap_pvt_thread_mutex_t	si_ops_mutex;
+	ldap_pvt_thread_mutex_t	si_eqkeys_mutex;
 	ldap_pvt_thread_mutex_t	si_mods_mutex;
 	ldap_pvt_thread_mutex_t	si_resp_mutex;
 } syncprov_info_t;
@@ -867,6 +891,138 @@ static void free_resinfo( syncres *sr )
 	}
 }
 
+static int
+syncprov_eqkey_cmp( const void *v_a, const void *v_b )
+{
+	const syncops_eqkey *a = v_a, *b = v_b;
+
+	if ( a->ek_ad != b->ek_ad )
+		return a->ek_ad < b->ek_ad ? -1 : 1;
+	return ber_bvcmp( &a->ek_val, &b->ek_val );
+}
+
+static int
+syncprov_eqkey_usable( Filter *f )
+{
+	AttributeDescription *ad;
+
+	if ( f->f_choice != LDAP_FILTER_EQUALITY )
+		return 0;
+#ifdef LDAP_COMP_MATCH
+	if ( f->f_ava->aa_cf )
+		return 0;
+#endif
+	ad = f->f_av_desc;
+	/* these are computed by test_ava_filter, not looked up */
+	if ( ad == slap_schema.si_ad_hasSubordinates ||
+		ad == slap_schema.si_ad_entryDN )
+		return 0;
+	return ad->ad_type->sat_equality != NULL;
+}
+
+/* Find an equality assertion that any entry matching the psearch filter
+ * must satisfy: the filter itself or one of its top level AND terms.
+ * objectClass is only used as a last resort since most psearches share it.
+ */
+static void
+syncprov_eqkey_get( syncprov_info_t *si, syncops *so, Filter *f )
+{
+	syncops_eqkey *ek, key;
+	Filter *fk = NULL;
+
+	if ( f->f_choice == LDAP_FILTER_AND ) {
+		Filter *fa;
+
+		for ( fa = f->f_and; fa; fa = fa->f_next ) {
+			if ( !syncprov_eqkey_usable( fa ))
+				continue;
+			fk = fa;
+			if ( fa->f_av_desc != slap_schema.si_ad_objectClass )
+				break;
+		}
+	} else if ( syncprov_eqkey_usable( f )) {
+		fk = f;
+	}
+	if ( !fk )
+		return;
+
+	key.ek_ad = fk->f_av_desc;
+	key.ek_val = fk->f_av_value;
+
+	ldap_pvt_thread_mutex_lock( &si->si_eqkeys_mutex );
+	ek = ldap_tavl_find( si->si_eqkeys, &key, syncprov_eqkey_cmp );
+	if ( !ek ) {
+		ek = ch_calloc( 1, sizeof( syncops_eqkey ) + key.ek_val.bv_len + 1 );
+		ek->ek_ad = key.ek_ad;
+		ek->ek_val.bv_val = (char *)(ek + 1);
+		ek->ek_val.bv_len = key.ek_val.bv_len;
+		AC_MEMCPY( ek->ek_val.bv_val, key.ek_val.bv_val, key.ek_val.bv_len );
+		ldap_tavl_insert( &si->si_eqkeys, ek, syncprov_eqkey_cmp,
+			ldap_avl_dup_error );
+	}
+	ek->ek_refcnt++;
+	ldap_pvt_thread_mutex_unlock( &si->si_eqkeys_mutex );
+
+	so->s_eqkey = ek;
+}
+
+static void
+syncprov_eqkey_release( syncprov_info_t *si, syncops *so )
+{
+	syncops_eqkey *ek = so->s_eqkey;
+
+	if ( !ek )
+		return;
+	so->s_eqkey = NULL;
+
+	ldap_pvt_thread_mutex_lock( &si->si_eqkeys_mutex );
+	if ( !--ek->ek_refcnt ) {
+		ldap_tavl_delete( &si->si_eqkeys, ek, syncprov_eqkey_cmp );
+		ch_free( ek );
+	}
+	ldap_pvt_thread_mutex_unlock( &si->si_eqkeys_mutex );
+}
+
+/* Check the assertion against an entry the same way test_ava_filter()
+ * would, minus access control. Returns 0 only if the entry cannot
+ * possibly satisfy it.
+ */
+static int
+syncprov_eqkey_test( syncops_eqkey *ek, Entry *e )
+{
+	Attribute *a;
+
+	for ( a = attrs_find( e->e_attrs, ek->ek_ad ); a;
+		a = attrs_find( a->a_next, ek->ek_ad ))
+	{
+		MatchingRule *mr = a->a_desc->ad_type->sat_equality;
+		struct berval *bv;
+		const char *text;
+		int rc, match;
+
+		if ( !mr )
+			continue;
+
+		if ( a->a_flags & SLAP_ATTR_SORTED_VALS ) {
+			rc = attr_valfind( a, SLAP_MR_EQUALITY |
+				SLAP_MR_ASSERTED_VALUE_NORMALIZED_MATCH |
+				SLAP_MR_ATTRIBUTE_VALUE_NORMALIZED_MATCH,
+				&ek->ek_val, NULL, NULL );
+			if ( rc != LDAP_NO_SUCH_ATTRIBUTE )
+				return 1;
+			continue;
+		}
+
+		for ( bv = a->a_nvals; !BER_BVISNULL( bv ); bv++ ) {
+			rc = ordered_value_match( &match, a->a_desc, mr,
+				SLAP_MR_EQUALITY, bv, &ek->ek_val, &text );
+			if ( rc != LDAP_SUCCESS || match == 0 )
+				return 1;
+		}
+	}
+	return 0;
+}
+
 #define FS_UNLINK	1
 #define FS_LOCK		2
 
@@ -904,6 +1060,8 @@ syncprov_free_syncop( syncops *so, int flags )
 		}
 		ch_free( so->s_op );
 	}
+	if ( so->s_si )
+		syncprov_eqkey_release( so->s_si, so );
 	ch_free( so->s_base.bv_val );
 	for ( sr=so->s_res; sr; sr=srnext ) {
 		srnext = sr->s_next;
@@ -1004,7 +1162,15 @@ static int
 syncprov_qplay( Operation *op, syncops *so )
 {
 	syncres *sr;
-	int rc = 0;
+	int rc = 0, nsent = 0, batchops = 1, batchtime = 0;
+	struct timeval start, now;
+
+	if ( so->s_si && so->s_si->si_batchops > 1 ) {
+		batchops = so->s_si->si_batchops;
+		batchtime = so->s_si->si_batchtime;
+		if ( batchtime )
+			gettimeofday( &start, NULL );
+	}
 
 	do {
 		ldap_pvt_thread_mutex_lock( &so->s_mutex );
@@ -1035,14 +1201,25 @@ syncprov_qplay( Operation *op, syncops *so )
 		if ( so->s_op->o_abandon )
 			continue;
 
+		/* Keep going while this run's batch and time slice allow */
+		if ( rc == 0 && ++nsent < batchops ) {
+			if ( !batchtime )
+				continue;
+			gettimeofday( &now, NULL );
+			if (( now.tv_sec - start.tv_sec ) * 1000 +
+				( now.tv_usec - start.tv_usec ) / 1000 < batchtime )
+				continue;
+		}
+
 		/* Exit loop with mutex held */
 		ldap_pvt_thread_mutex_lock( &so->s_mutex );
 		break;
 
 	} while (1);
 
-	/* We now only send one change at a time, to prevent one
-	 * psearch from hogging all the CPU. Resubmit this task if
+	/* By default we only send one change at a time, to prevent one
+	 * psearch from hogging all the CPU; syncprov-batch allows more
+	 * per run, bounded by its time slice. Resubmit this task if
 	 * there are more responses queued and no errors occurred.
 	 */
 
@@ -1350,6 +1527,7 @@ syncprov_matchops( Operation *op, opcookie *opc, int saveit )
 	}
 
 	ldap_pvt_thread_mutex_lock( &si->si_ops_mutex );
+	si->si_matchgen++;
 	for (pss = &si->si_ops; *pss; pss = gonext ? &(*pss)->s_next : pss)
 	{
 		Operation op2;
@@ -1418,7 +1596,24 @@ syncprov_matchops( Operation *op, opcookie *opc, int saveit )
 			}
 		}
 
+		/* Each distinct equality assertion is only checked once per
+		 * change, psearches whose assertion fails skip test_filter
+		 */
+		if ( fc.fscope && ss->s_eqkey ) {
+			syncops_eqkey *ek = ss->s_eqkey;
+
+			if ( ek->ek_gen != si->si_matchgen ) {
+				ek->ek_gen = si->si_matchgen;
+				ek->ek_match = syncprov_eqkey_test( ek, e );
+			}
+			if ( !ek->ek_match ) {
+				si->si_nmatchskips++;
+				fc.fscope = 0;
+			}
+		}
+
 		if ( fc.fscope ) {
+			si->si_nmatchtests++;
 			ldap_pvt_thread_mutex_lock( &ss->s_mutex );
 			op2 = *ss->s_op;
 			oh = *op->o_hdr;
@@ -1444,6 +1639,7 @@ syncprov_matchops( Operation *op, opcookie *opc, int saveit )
 
 		/* check if current o_req_dn is in scope and matches filter */
 		if ( fc.fscope && rc == LDAP_COMPARE_TRUE ) {
+			si->si_nmatches++;
 			if ( saveit ) {
 				sm = op->o_tmpalloc( sizeof(syncmatches), op->o_tmpmemctx );
 				sm->sm_next = opc->smatches;
@@ -1719,9 +1915,8 @@ syncprov_add_slog( Operation *op )
 				Debug( LDAP_DEBUG_SYNC, "%s syncprov_add_slog: "
 					"expiring csn=%s from sessionlog (sessionlog size=%d)\n",
 					op->o_log_prefix, se->se_csn.bv_val, sl->sl_num );
-				for ( i=0; i<sl->sl_numcsns; i++ )
-					if ( sl->sl_sids[i] >= se->se_sid )
-						break;
+				i = slap_csn_sid_slot( sl->sl_sids, sl->sl_numcsns,
+					se->se_sid );
 				if  ( i == sl->sl_numcsns || sl->sl_sids[i] != se->se_sid ) {
 					Debug( LDAP_DEBUG_SYNC, "%s syncprov_add_slog: "
 						"adding csn=%s to mincsn\n",
@@ -1900,12 +2095,9 @@ syncprov_accesslog_uuid_cb( Operation *op, SlapReply *rs )
 	 * newer than cookieCSN (srs->sr_state.ctxcsn)
 	 */
 	cmp = 1;
-	for ( i=0; i<srs->sr_state.numcsns; i++ ) {
-		if ( sid == srs->sr_state.sids[i] ) {
-			cmp = ber_bvcmp( &csn[0], &srs->sr_state.ctxcsn[i] );
-			break;
-		}
-	}
+	i = slap_csn_sid_slot( srs->sr_state.sids, srs->sr_state.numcsns, sid );
+	if ( i < srs->sr_state.numcsns && sid == srs->sr_state.sids[i] )
+		cmp = ber_bvcmp( &csn[0], &srs->sr_state.ctxcsn[i] );
 	if ( cmp <= 0 ) {
 		Debug( LDAP_DEBUG_SYNC, "%s syncprov_accesslog_uuid_cb: "
 				"cmp %d, csn %s too old\n",
@@ -1917,12 +2109,9 @@ syncprov_accesslog_uuid_cb( Operation *op, SlapReply *rs )
 	 * not newer than snapshot ctxcsn (uuid_progress->ctxcsn)
 	 */
 	cmp = 0;
-	for ( i=0; i<uuid_progress->numcsns; i++ ) {
-		if ( sid == uuid_progress->sids[i] ) {
-			cmp = ber_bvcmp( &csn[0], &uuid_progress->ctxcsn[i] );
-			break;
-		}
-	}
+	i = slap_csn_sid_slot( uuid_progress->sids, uuid_progress->numcsns, sid );
+	if ( i < uuid_progress->numcsns && sid == uuid_progress->sids[i] )
+		cmp = ber_bvcmp( &csn[0], &uuid_progress->ctxcsn[i] );
 	if ( cmp > 0 ) {
 		Debug( LDAP_DEBUG_SYNC, "%s syncprov_accesslog_uuid_cb: "
 				"cmp %d, csn %s too new\n",
@@ -2398,19 +2587,13 @@ syncprov_new_ctxcsn( opcookie *opc, syncprov_info_t *si, int csn_changed, int nu
 
 	for ( i=0; i<numvals; i++ ) {
 		sid = slap_parse_csn_sid( &vals[i] );
-		for ( j=0; j<si->si_numcsns; j++ ) {
-			if ( sid < si->si_sids[j] )
-				break;
-			if ( sid == si->si_sids[j] ) {
-				if ( ber_bvcmp( &vals[i], &si->si_ctxcsn[j] ) > 0 ) {
-					ber_bvreplace( &si->si_ctxcsn[j], &vals[i] );
-					csn_changed = 1;
-				}
-				break;
+		j = slap_csn_sid_slot( si->si_sids, si->si_numcsns, sid );
+		if ( j < si->si_numcsns && sid == si->si_sids[j] ) {
+			if ( ber_bvcmp( &vals[i], &si->si_ctxcsn[j] ) > 0 ) {
+				ber_bvreplace( &si->si_ctxcsn[j], &vals[i] );
+				csn_changed = 1;
 			}
-		}
-
-		if ( j == si->si_numcsns || sid != si->si_sids[j] ) {
+		} else {
 			slap_insert_csn_sids( (struct sync_cookie *)&si->si_ctxcsn,
 				j, sid, &vals[i] );
 			csn_changed = 1;
@@ -2482,19 +2665,14 @@ syncprov_op_response( Operation *op, SlapReply *rs )
 			assert( !syn->ssyn_validate( syn, &maxcsn ));
 #endif
 			sid = slap_parse_csn_sid( &maxcsn );
-			for ( i=0; i<si->si_numcsns; i++ ) {
-				if ( sid < si->si_sids[i] )
-					break;
-				if ( sid == si->si_sids[i] ) {
-					if ( ber_bvcmp( &maxcsn, &si->si_ctxcsn[i] ) > 0 ) {
-						ber_bvreplace( &si->si_ctxcsn[i], &maxcsn );
-						csn_changed = 1;
-					}
-					break;
+			i = slap_csn_sid_slot( si->si_sids, si->si_numcsns, sid );
+			if ( i < si->si_numcsns && sid == si->si_sids[i] ) {
+				if ( ber_bvcmp( &maxcsn, &si->si_ctxcsn[i] ) > 0 ) {
+					ber_bvreplace( &si->si_ctxcsn[i], &maxcsn );
+					csn_changed = 1;
 				}
-			}
-			/* It's a new SID for us */
-			if ( i == si->si_numcsns || sid != si->si_sids[i] ) {
+			} else {
+				/* It's a new SID for us */
 				slap_insert_csn_sids((struct sync_cookie *)&(si->si_ctxcsn),
 					i, sid, &maxcsn );
 				csn_changed = 1;
@@ -2974,34 +3152,34 @@ syncprov_search_response( Operation *op, SlapReply *rs )
 			/* If not a persistent search */
 			if ( !ss->ss_so ) {
 				/* Make sure entry is less than the snapshot'd contextCSN */
-				for ( i=0; i<ss->ss_numcsns; i++ ) {
-					if ( sid == ss->ss_sids[i] && ber_bvcmp( &a->a_nvals[0],
-						&ss->ss_ctxcsn[i] ) > 0 ) {
-						Debug( LDAP_DEBUG_SYNC, "%s syncprov_search_response: "
-							"Entry %s CSN %s greater than snapshot %s\n",
-							op->o_log_prefix,
-							rs->sr_entry->e_name.bv_val,
-							a->a_nvals[0].bv_val,
-							ss->ss_ctxcsn[i].bv_val );
-						return LDAP_SUCCESS;
-					}
+				i = slap_csn_sid_slot( ss->ss_sids, ss->ss_numcsns, sid );
+				if ( i < ss->ss_numcsns && sid == ss->ss_sids[i] &&
+					ber_bvcmp( &a->a_nvals[0], &ss->ss_ctxcsn[i] ) > 0 ) {
+					Debug( LDAP_DEBUG_SYNC, "%s syncprov_search_response: "
+						"Entry %s CSN %s greater than snapshot %s\n",
+						op->o_log_prefix,
+						rs->sr_entry->e_name.bv_val,
+						a->a_nvals[0].bv_val,
+						ss->ss_ctxcsn[i].bv_val );
+					return LDAP_SUCCESS;
 				}
 			}
 
 			/* Don't send old entries twice */
 			if ( srs->sr_state.ctxcsn ) {
-				for ( i=0; i<srs->sr_state.numcsns; i++ ) {
-					if ( sid == srs->sr_state.sids[i] &&
-						ber_bvcmp( &a->a_nvals[0],
-							&srs->sr_state.ctxcsn[i] )<= 0 ) {
-						Debug( LDAP_DEBUG_SYNC, "%s syncprov_search_response: "
-							"Entry %s CSN %s older or equal to ctx %s\n",
-							op->o_log_prefix,
-							rs->sr_entry->e_name.bv_val,
-							a->a_nvals[0].bv_val,
-							srs->sr_state.ctxcsn[i].bv_val );
-						return LDAP_SUCCESS;
-					}
+				i = slap_csn_sid_slot( srs->sr_state.sids,
+					srs->sr_state.numcsns, sid );
+				if ( i < srs->sr_state.numcsns &&
+					sid == srs->sr_state.sids[i] &&
+					ber_bvcmp( &a->a_nvals[0],
+						&srs->sr_state.ctxcsn[i] )<= 0 ) {
+					Debug( LDAP_DEBUG_SYNC, "%s syncprov_search_response: "
+						"Entry %s CSN %s older or equal to ctx %s\n",
+						op->o_log_prefix,
+						rs->sr_entry->e_name.bv_val,
+						a->a_nvals[0].bv_val,
+						srs->sr_state.ctxcsn[i].bv_val );
+					return LDAP_SUCCESS;
 				}
 			}
 		}
@@ -3177,6 +3355,7 @@ aband:
 			goto aband;
 		}
 		ldap_pvt_thread_mutex_init( &sop->s_mutex );
+		syncprov_eqkey_get( si, sop, op->ors_filter );
 		sop->s_next = si->si_ops;
 		sop->s_si = si;
 		si->si_ops = sop;
@@ -3297,6 +3476,7 @@ bailout:
 						sp = &(*sp)->s_next;
 					*sp = sop->s_next;
 					ldap_pvt_thread_mutex_unlock( &si->si_ops_mutex );
+					syncprov_eqkey_release( si, sop );
 					ch_free( sop->s_base.bv_val );
 					ch_free( sop );
 				}
@@ -3643,7 +3823,8 @@ enum {
 	SP_SESSL,
 	SP_NOPRES,
 	SP_USEHINT,
-	SP_LOGDB
+	SP_LOGDB,
+	SP_BATCH
 };
 
 static ConfigDriver sp_cf_gen;
@@ -3673,6 +3854,11 @@ static ConfigTable spcfg[] = {
 		sp_cf_gen, "( OLcfgOvAt:1.5 NAME 'olcSpSessionlogSource' "
 			"DESC 'On startup, try loading sessionlog from this subtree' "
 			"SYNTAX OMsDN SINGLE-VALUE )", NULL, NULL },
+	{ "syncprov-batch", "ops> [<msecs>", 2, 3, 0, ARG_MAGIC|SP_BATCH,
+		sp_cf_gen, "( OLcfgOvAt:1.6 NAME 'olcSpBatch' "
+			"DESC 'Max queued responses sent per psearch task run, and time slice in msecs' "
+			"EQUALITY caseIgnoreMatch "
+			"SYNTAX OMsDirectoryString SINGLE-VALUE )", NULL, NULL },
 	{ NULL, NULL, 0, 0, 0, ARG_IGNORED }
 };
 
@@ -3686,6 +3872,7 @@ static ConfigOCs spocs[] = {
 			"$ olcSpNoPresent "
 			"$ olcSpReloadHint "
 			"$ olcSpSessionlogSource "
+			"$ olcSpBatch "
 		") )",
 			Cft_Overlay, spcfg },
 	{ NULL, 0, NULL }
@@ -3747,6 +3934,25 @@ sp_cf_gen(ConfigArgs *c)
 				value_add_one( &c->rvalue_nvals, &si->si_logbase );
 			}
 			break;
+		case SP_BATCH:
+			if ( si->si_batchops ) {
+				struct berval bv;
+				if ( si->si_batchtime )
+					bv.bv_len = snprintf( c->cr_msg, sizeof( c->cr_msg ),
+						"%d %d", si->si_batchops, si->si_batchtime );
+				else
+					bv.bv_len = snprintf( c->cr_msg, sizeof( c->cr_msg ),
+						"%d", si->si_batchops );
+				if ( bv.bv_len >= sizeof( c->cr_msg ) ) {
+					rc = 1;
+				} else {
+					bv.bv_val = c->cr_msg;
+					value_add_one( &c->rvalue_vals, &bv );
+				}
+			} else {
+				rc = 1;
+			}
+			break;
 		}
 		return rc;
 	} else if ( c->op == LDAP_MOD_DELETE ) {
@@ -3771,6 +3977,10 @@ sp_cf_gen(ConfigArgs *c)
 				BER_BVZERO( &si->si_logbase );
 			}
 			break;
+		case SP_BATCH:
+			si->si_batchops = 0;
+			si->si_batchtime = 0;
+			break;
 		}
 		return rc;
 	}
@@ -3864,6 +4074,28 @@ sp_cf_gen(ConfigArgs *c)
 		rc = syncprov_setup_accesslog();
 		ch_free( c->value_dn.bv_val );
 		break;
+	case SP_BATCH: {
+		int ops, msecs = 0;
+
+		if ( lutil_atoi( &ops, c->argv[1] ) != 0 || ops <= 0 ) {
+			snprintf( c->cr_msg, sizeof( c->cr_msg ), "%s invalid batch ops # \"%s\"",
+				c->argv[0], c->argv[1] );
+			Debug( LDAP_DEBUG_CONFIG|LDAP_DEBUG_NONE,
+				"%s: %s\n", c->log, c->cr_msg );
+			return ARG_BAD_CONF;
+		}
+		if ( c->argc > 2 &&
+			( lutil_atoi( &msecs, c->argv[2] ) != 0 || msecs < 0 )) {
+			snprintf( c->cr_msg, sizeof( c->cr_msg ), "%s invalid batch time \"%s\"",
+				c->argv[0], c->argv[2] );
+			Debug( LDAP_DEBUG_CONFIG|LDAP_DEBUG_NONE,
+				"%s: %s\n", c->log, c->cr_msg );
+			return ARG_BAD_CONF;
+		}
+		si->si_batchops = ops;
+		si->si_batchtime = msecs;
+		}
+		break;
 	}
 	return rc;
 }
@@ -3924,6 +4156,337 @@ syncprov_db_otask2(
 	return NULL;
 }
 
+static ObjectClass		*oc_olmSyncProv;
+
+static AttributeDescription	*ad_olmSyncProvPsearches,
+	*ad_olmSyncProvMatchTests, *ad_olmSyncProvMatchSkips,
+	*ad_olmSyncProvMatches;
+
+static struct {
+	char			*name;
+	char			*oid;
+}		s_oid[] = {
+	{ "olmSyncProvAttributes",		"olmOverlayAttributes:2" },
+	{ "olmSyncProvObjectClasses",		"olmOverlayObjectClasses:2" },
+
+	{ NULL }
+};
+
+static struct {
+	char			*desc;
+	AttributeDescription	**ad;
+}		s_at[] = {
+	{ "( olmSyncProvAttributes:1 "
+		"NAME ( 'olmSyncProvPsearches' ) "
+		"DESC 'Number of active persistent searches' "
+		"SUP monitorCounter "
+		"NO-USER-MODIFICATION "
+		"USAGE dSAOperation )",
+		&ad_olmSyncProvPsearches },
+
+	{ "( olmSyncProvAttributes:2 "
+		"NAME ( 'olmSyncProvMatchTests' ) "
+		"DESC 'Number of persistent search filters evaluated' "
+		"SUP monitorCounter "
+		"NO-USER-MODIFICATION "
+		"USAGE dSAOperation )",
+		&ad_olmSyncProvMatchTests },
+
+	{ "( olmSyncProvAttributes:3 "
+		"NAME ( 'olmSyncProvMatchSkips' ) "
+		"DESC 'Number of persistent search filter evaluations "
+			"avoided by the equality index' "
+		"SUP monitorCounter "
+		"NO-USER-MODIFICATION "
+		"USAGE dSAOperation )",
+		&ad_olmSyncProvMatchSkips },
+
+	{ "( olmSyncProvAttributes:4 "
+		"NAME ( 'olmSyncProvMatches' ) "
+		"DESC 'Number of persistent searches that matched a change' "
+		"SUP monitorCounter "
+		"NO-USER-MODIFICATION "
+		"USAGE dSAOperation )",
+		&ad_olmSyncProvMatches },
+
+	{ NULL }
+};
+
+static struct {
+	char		*desc;
+	ObjectClass	**oc;
+}		s_oc[] = {
+	/* augments an existing object, so it must be AUXILIARY */
+	{ "( olmSyncProvObjectClasses:1 "
+		"NAME ( 'olmSyncProv' ) "
+		"SUP top AUXILIARY "
+		"MAY ( "
+			"olmSyncProvPsearches "
+			"$ olmSyncProvMatchTests "
+			"$ olmSyncProvMatchSkips "
+			"$ olmSyncProvMatches "
+			") )",
+		&oc_olmSyncProv },
+
+	{ NULL }
+};
+
+static void
+syncprov_monitor_set( Entry *e, AttributeDescription *ad, unsigned long n )
+{
+	Attribute *a;
+	char buf[ LDAP_PVT_INTTYPE_CHARS(unsigned long) ];
+	struct berval bv;
+
+	a = attr_find( e->e_attrs, ad );
+	assert( a != NULL );
+	bv.bv_val = buf;
+	bv.bv_len = snprintf( buf, sizeof( buf ), "%lu", n );
+	ber_bvreplace( &a->a_vals[ 0 ], &bv );
+}
+
+static int
+syncprov_monitor_update(
+	Operation	*op,
+	SlapReply	*rs,
+	Entry		*e,
+	void		*priv )
+{
+	syncprov_info_t	*si = (syncprov_info_t *) priv;
+	syncops *so;
+	unsigned long npsearches = 0, ntests, nskips, nmatches;
+
+	ldap_pvt_thread_mutex_lock( &si->si_ops_mutex );
+	for ( so = si->si_ops; so; so = so->s_next )
+		npsearches++;
+	ntests = si->si_nmatchtests;
+	nskips = si->si_nmatchskips;
+	nmatches = si->si_nmatches;
+	ldap_pvt_thread_mutex_unlock( &si->si_ops_mutex );
+
+	syncprov_monitor_set( e, ad_olmSyncProvPsearches, npsearches );
+	syncprov_monitor_set( e, ad_olmSyncProvMatchTests, ntests );
+	syncprov_monitor_set( e, ad_olmSyncProvMatchSkips, nskips );
+	syncprov_monitor_set( e, ad_olmSyncProvMatches, nmatches );
+
+	return SLAP_CB_CONTINUE;
+}
+
+static int
+syncprov_monitor_free(
+	Entry		*e,
+	void		**priv )
+{
+	struct berval	values[ 2 ];
+	Modification	mod = { 0 };
+
+	const char	*text;
+	char		textbuf[ SLAP_TEXT_BUFLEN ];
+
+	int		i;
+
+	/* NOTE: if slap_shutdown != 0, priv might have already been freed */
+	*priv = NULL;
+
+	/* Remove objectClass */
+	mod.sm_op = LDAP_MOD_DELETE;
+	mod.sm_desc = slap_schema.si_ad_objectClass;
+	mod.sm_values = values;
+	mod.sm_numvals = 1;
+	values[ 0 ] = oc_olmSyncProv->soc_cname;
+	BER_BVZERO( &values[ 1 ] );
+
+	modify_delete_values( e, &mod, 1, &text,
+		textbuf, sizeof( textbuf ) );
+	/* don't care too much about return code... */
+
+	/* remove attrs */
+	mod.sm_values = NULL;
+	mod.sm_numvals = 0;
+	for ( i = 0; s_at[ i ].desc != NULL; i++ ) {
+		mod.sm_desc = *s_at[ i ].ad;
+		modify_delete_values( e, &mod, 1, &text,
+			textbuf, sizeof( textbuf ) );
+		/* don't care too much about return code... */
+	}
+
+	return SLAP_CB_CONTINUE;
+}
+
+/*
+ * call from within syncprov_db_init()
+ */
+static int
+syncprov_monitor_initialize( void )
+{
+	int		i, code;
+	ConfigArgs c;
+	char	*argv[ 3 ];
+
+	static int	syncprov_monitor_initialized = 0;
+
+	/* set to 0 when successfully initialized; otherwise, remember failure */
+	static int	syncprov_monitor_initialized_failure = 1;
+
+	if ( syncprov_monitor_initialized++ ) {
+		return syncprov_monitor_initialized_failure;
+	}
+
+	if ( backend_info( "monitor" ) == NULL ) {
+		return -1;
+	}
+
+	argv[ 0 ] = "syncprov monitor";
+	c.argv = argv;
+	c.argc = 3;
+	c.fname = argv[0];
+
+	for ( i = 0; s_oid[ i ].name; i++ ) {
+		c.lineno = i;
+		argv[ 1 ] = s_oid[ i ].name;
+		argv[ 2 ] = s_oid[ i ].oid;
+
+		if ( parse_oidm( &c, 0, NULL ) != 0 ) {
+			Debug( LDAP_DEBUG_ANY, "syncprov_monitor_initialize: "
+				"unable to add objectIdentifier \"%s=%s\"\n",
+				s_oid[ i ].name, s_oid[ i ].oid );
+			return 2;
+		}
+	}
+
+	for ( i = 0; s_at[ i ].desc != NULL; i++ ) {
+		code = register_at( s_at[ i ].desc, s_at[ i ].ad, 1 );
+		if ( code != LDAP_SUCCESS ) {
+			Debug( LDAP_DEBUG_ANY, "syncprov_monitor_initialize: "
+				"register_at failed for attributeType (%s)\n",
+				s_at[ i ].desc );
+			return 3;
+
+		} else {
+			(*s_at[ i ].ad)->ad_type->sat_flags |= SLAP_AT_HIDE;
+		}
+	}
+
+	for ( i = 0; s_oc[ i ].desc != NULL; i++ ) {
+		code = register_oc( s_oc[ i ].desc, s_oc[ i ].oc, 1 );
+		if ( code != LDAP_SUCCESS ) {
+			Debug( LDAP_DEBUG_ANY, "syncprov_monitor_initialize: "
+				"register_oc failed for objectClass (%s)\n",
+				s_oc[ i ].desc );
+			return 4;
+
+		} else {
+			(*s_oc[ i ].oc)->soc_flags |= SLAP_OC_HIDE;
+		}
+	}
+
+	return ( syncprov_monitor_initialized_failure = LDAP_SUCCESS );
+}
+
+static int
+syncprov_monitor_db_open( BackendDB *be )
+{
+	slap_overinst		*on = (slap_overinst *)be->bd_info;
+	syncprov_info_t		*si = on->on_bi.bi_private;
+	Attribute		*a, *next;
+	monitor_callback_t	*cb = NULL;
+	int			i, rc = 0;
+	BackendInfo		*mi;
+	monitor_extra_t		*mbe;
+
+	/* schema registration failed, or monitoring is off */
+	if ( !oc_olmSyncProv || !SLAP_DBMONITORING( be ) ) {
+		return 0;
+	}
+
+	mi = backend_info( "monitor" );
+	if ( !mi || !mi->bi_extra ) {
+		return 0;
+	}
+	mbe = mi->bi_extra;
+
+	/* don't bother if monitor is not configured */
+	if ( !mbe->is_configured() ) {
+		return 0;
+	}
+
+	/* alloc as many as required (plus 1 for objectClass) */
+	for ( i = 0; s_at[ i ].desc != NULL; i++ )
+		;
+	a = attrs_alloc( 1 + i );
+	if ( a == NULL ) {
+		rc = 1;
+		goto cleanup;
+	}
+
+	a->a_desc = slap_schema.si_ad_objectClass;
+	attr_valadd( a, &oc_olmSyncProv->soc_cname, NULL, 1 );
+	next = a->a_next;
+
+	for ( i = 0; s_at[ i ].desc != NULL; i++ ) {
+		struct berval	bv = BER_BVC( "0" );
+
+		next->a_desc = *s_at[ i ].ad;
+		attr_valadd( next, &bv, NULL, 1 );
+		next = next->a_next;
+	}
+
+	cb = ch_calloc( sizeof( monitor_callback_t ), 1 );
+	cb->mc_update = syncprov_monitor_update;
+	cb->mc_free = syncprov_monitor_free;
+	cb->mc_private = (void *)si;
+
+	/* make sure the database is registered; then add monitor attributes */
+	BER_BVZERO( &si->si_monitor_ndn );
+	rc = mbe->register_database( be, &si->si_monitor_ndn );
+	if ( rc == 0 ) {
+		rc = mbe->register_entry_attrs( &si->si_monitor_ndn, a, cb,
+			NULL, -1, NULL );
+	}
+
+cleanup:;
+	if ( rc != 0 ) {
+		if ( cb != NULL ) {
+			ch_free( cb );
+			cb = NULL;
+		}
+	}
+
+	/* store for cleanup */
+	si->si_monitor_cb = (void *)cb;
+
+	/* we don't need to keep track of the attributes, because
+	 * syncprov_monitor_free() takes care of everything */
+	if ( a != NULL ) {
+		attrs_free( a );
+	}
+
+	return rc;
+}
+
+static int
+syncprov_monitor_db_close( BackendDB *be )
+{
+	slap_overinst		*on = (slap_overinst *)be->bd_info;
+	syncprov_info_t		*si = on->on_bi.bi_private;
+
+	if ( !BER_BVISNULL( &si->si_monitor_ndn )) {
+		BackendInfo		*mi = backend_info( "monitor" );
+		monitor_extra_t		*mbe;
+
+		if ( mi && mi->bi_extra ) {
+			struct berval dummy = BER_BVNULL;
+			mbe = mi->bi_extra;
+			mbe->unregister_entry_callback( &si->si_monitor_ndn,
+				(monitor_callback_t *)si->si_monitor_cb,
+				&dummy, 0, &dummy );
+		}
+		BER_BVZERO( &si->si_monitor_ndn );
+	}
+
+	return 0;
+}
+
 /* Read any existing contextCSN from the underlying db.
  * Then search for any entries newer than that. If no value exists,
  * just generate it. Cache whatever result.
@@ -3964,6 +4527,25 @@ syncprov_db_open(
 		"starting syncprov for suffix %s\n",
 		be->be_suffix[0].bv_val );
 
+	if ( !BER_BVISNULL( &si->si_logbase ) ) {
+		slap_overinst *lo;
+
+		/* Without accesslog on this database nothing gets logged there,
+		 * and every refresh would silently fall back to the present phase.
+		 * be->bd_info is our own overinst here, so walk the overlay list. */
+		for ( lo = on->on_info->oi_list; lo; lo = lo->on_next ) {
+			if ( !( lo->on_bi.bi_flags & SLAPO_BFLAG_DISABLED ) &&
+				strcmp( lo->on_bi.bi_type, "accesslog" ) == 0 )
+				break;
+		}
+		if ( !lo ) {
+			Debug( LDAP_DEBUG_ANY, "syncprov_db_open: "
+					"accesslog overlay is not configured on this database, "
+					"sessionlog source dn='%s' will not see its changes\n",
+					si->si_logbase.bv_val );
+		}
+	}
+
 	thrctx = ldap_pvt_thread_pool_context();
 	connection_fake_init2( &conn, &opbuf, thrctx, 0 );
 	op = &opbuf.ob_op;
@@ -4067,6 +4649,7 @@ syncprov_db_open(
 
 out:
 	op->o_bd->bd_info = (BackendInfo *)on;
+	syncprov_monitor_db_open( be );
 	return 0;
 }
 
@@ -4123,6 +4706,8 @@ syncprov_db_close(
 	overlay_unregister_control( be, LDAP_CONTROL_SYNC );
 #endif /* SLAP_CONFIG_DELETE */
 
+	syncprov_monitor_db_close( be );
+
 	return 0;
 }
 
@@ -4145,9 +4730,13 @@ syncprov_db_init(
 	on->on_bi.bi_private = si;
 	ldap_pvt_thread_rdwr_init( &si->si_csn_rwlock );
 	ldap_pvt_thread_mutex_init( &si->si_ops_mutex );
+	ldap_pvt_thread_mutex_init( &si->si_eqkeys_mutex );
 	ldap_pvt_thread_mutex_init( &si->si_mods_mutex );
 	ldap_pvt_thread_mutex_init( &si->si_resp_mutex );
 
+	/* only reports if the underlying database has monitoring on */
+	syncprov_monitor_initialize();
+
 	csn_anlist[0].an_desc = slap_schema.si_ad_entryCSN;
 	csn_anlist[0].an_name = slap_schema.si_ad_entryCSN->ad_cname;
 	csn_anlist[1].an_desc = slap_schema.si_ad_entryUUID;
@@ -4188,7 +4777,9 @@ syncprov_db_destroy(
 		if ( si->si_logbase.bv_val )
 			ch_free( si->si_logbase.bv_val );
 		ldap_pvt_thread_mutex_destroy( &si->si_resp_mutex );
+		ldap_tavl_free( si->si_eqkeys, (AVL_FREE)ch_free );
 		ldap_pvt_thread_mutex_destroy( &si->si_mods_mutex );
+		ldap_pvt_thread_mutex_destroy( &si->si_eqkeys_mutex );
 		ldap_pvt_thread_mutex_destroy( &si->si_ops_mutex );
 		ldap_pvt_thread_rdwr_destroy( &si->si_csn_rwlock );
 		ch_free( si );
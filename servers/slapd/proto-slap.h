@@ -220,7 +220,6 @@ LDAP_SLAPD_F( int ) slap_add_opattrs(
 /*
  * at.c
  */
-LDAP_SLAPD_V(int) at_oc_cache;
 LDAP_SLAPD_F (void) at_config LDAP_P((
 	const char *fname, int lineno,
 	int argc, char **argv ));
@@ -309,6 +308,15 @@ LDAP_SLAPD_F (Attribute *) attrs_find LDAP_P((
 	Attribute *a, AttributeDescription *desc ));
 LDAP_SLAPD_F (Attribute *) attr_find LDAP_P((
 	Attribute *a, AttributeDescription *desc ));
+LDAP_SLAPD_F (size_t) entry_attr_index_size LDAP_P(( int nattrs ));
+LDAP_SLAPD_F (void) entry_attr_index LDAP_P((
+	Entry *e, void *buf, int nattrs ));
+LDAP_SLAPD_F (Attribute *) entry_attrs_find LDAP_P((
+	Entry *e, AttributeDescription *desc ));
+LDAP_SLAPD_F (Attribute *) entry_attrs_find_next LDAP_P((
+	Entry *e, Attribute *a, AttributeDescription *desc ));
+LDAP_SLAPD_F (Attribute *) entry_attr_find LDAP_P((
+	Entry *e, AttributeDescription *desc ));
 LDAP_SLAPD_F (int) attr_delete LDAP_P((
 	Attribute **attrs, AttributeDescription *desc ));
 
@@ -416,6 +424,15 @@ LDAP_SLAPD_F (int) backend_group LDAP_P((
 	AttributeDescription *group_at
 ));
 
+LDAP_SLAPD_F (void) slap_group_cache_init LDAP_P(( void ));
+LDAP_SLAPD_F (void) slap_group_cache_destroy LDAP_P(( void ));
+LDAP_SLAPD_F (unsigned long) slap_group_cache_gen LDAP_P(( void ));
+LDAP_SLAPD_F (void) slap_group_cache_flush LDAP_P(( void ));
+LDAP_SLAPD_F (void) slap_group_cache_invalidate LDAP_P((
+	struct berval *ndn, int subtree ));
+LDAP_SLAPD_F (void) slap_group_cache_stats LDAP_P((
+	slap_group_cache_stats_t *gs ));
+
 LDAP_SLAPD_F (int) backend_attribute LDAP_P((
 	Operation *op,
 	Entry *target,
@@ -1018,6 +1035,11 @@ LDAP_SLAPD_F (int) dnX509normalize LDAP_P(( void *x509_name, struct berval *out
 LDAP_SLAPD_F (int) dnX509peerNormalize LDAP_P(( void *ssl, struct berval *dn ));
 
 LDAP_SLAPD_F (int) dnPrettyNormalDN LDAP_P(( Syntax *syntax, struct berval *val, LDAPDN *dn, int flags, void *ctx ));
+
+LDAP_SLAPD_F (void) dn_cache_init LDAP_P(( void ));
+LDAP_SLAPD_F (void) dn_cache_flush LDAP_P(( void ));
+LDAP_SLAPD_F (void) dn_cache_destroy LDAP_P(( void ));
+LDAP_SLAPD_F (void) dn_cache_stats LDAP_P(( slap_dn_cache_stats_t *ds ));
 #define dnPrettyDN(syntax, val, dn, ctx) \
 	dnPrettyNormalDN((syntax),(val),(dn), SLAP_LDAPDN_PRETTY, ctx)
 #define dnNormalDN(syntax, val, dn, ctx) \
@@ -1154,6 +1176,10 @@ LDAP_SLAPD_F (void) filter_destroy LDAP_P(( void ));
  */
 
 LDAP_SLAPD_F (int) test_filter LDAP_P(( Operation *op, Entry *e, Filter *f ));
+LDAP_SLAPD_F (FilterProg *) filter_compile LDAP_P(( Operation *op, Filter *f ));
+LDAP_SLAPD_F (void) filter_prog_free LDAP_P(( Operation *op, FilterProg *fp ));
+LDAP_SLAPD_F (int) filter_prog_test LDAP_P(( Operation *op, Entry *e,
+	FilterProg *fp ));
 
 /*
  * frontend.c
@@ -1206,6 +1232,8 @@ LDAP_SLAPD_F (int) slap_sort_csn_sids LDAP_P((
 				BerVarray, int *, int, void *memctx ));
 LDAP_SLAPD_F (void) slap_insert_csn_sids LDAP_P((
 				struct sync_cookie *ck, int, int, struct berval * ));
+LDAP_SLAPD_F (int) slap_csn_sid_slot LDAP_P((
+				int *sids, int numcsns, int sid ));
 LDAP_SLAPD_F (int) slap_parse_sync_cookie LDAP_P((
 				struct sync_cookie *, void *memctx ));
 LDAP_SLAPD_F (void) slap_reparse_sync_cookie LDAP_P((
@@ -1501,6 +1529,7 @@ LDAP_SLAPD_F (void) slap_op_init LDAP_P(( void ));
 LDAP_SLAPD_F (void) slap_op_destroy LDAP_P(( void ));
 LDAP_SLAPD_F (void) slap_op_groups_free LDAP_P(( Operation *op ));
 LDAP_SLAPD_F (void) slap_op_free LDAP_P(( Operation *op, void *ctx ));
+LDAP_SLAPD_F (void) slap_op_pool_stats LDAP_P(( slap_op_pool_stats_t *ps ));
 LDAP_SLAPD_F (void) slap_op_time LDAP_P(( time_t *t, int *n ));
 LDAP_SLAPD_F (Operation *) slap_op_alloc LDAP_P((
 	BerElement *ber, ber_int_t msgid,
@@ -1770,6 +1799,14 @@ LDAP_SLAPD_F (int) authzNormalize LDAP_P((
  * schema.c
  */
 LDAP_SLAPD_F (int) schema_info LDAP_P(( Entry **entry, const char **text ));
+LDAP_SLAPD_F (void) schema_hash_insert LDAP_P((
+	SchemaHash **shp, struct berval *name ));
+LDAP_SLAPD_F (void) schema_hash_delete LDAP_P((
+	SchemaHash **shp, struct berval *name ));
+LDAP_SLAPD_F (struct berval *) schema_hash_find LDAP_P((
+	SchemaHash *sh, struct berval *name ));
+LDAP_SLAPD_F (void) schema_hash_free LDAP_P((
+	SchemaHash **shp ));
 
 /*
  * schema_check.c
@@ -2061,6 +2098,7 @@ LDAP_SLAPD_V (unsigned int) index_substr_if_minlen;
 LDAP_SLAPD_V (unsigned int) index_substr_if_maxlen;
 LDAP_SLAPD_V (unsigned int) index_substr_any_len;
 LDAP_SLAPD_V (unsigned int) index_substr_any_step;
+LDAP_SLAPD_V (int) index_substr_exact;
 LDAP_SLAPD_V (unsigned int) index_intlen;
 /* all signed integers from strings of this size need more than intlen bytes */
 /* i.e. log(10)*(index_intlen_strlen-2) > log(2)*(8*(index_intlen)-1) */
@@ -2071,7 +2109,12 @@ LDAP_SLAPD_V (ber_len_t) sockbuf_max_incoming;
 LDAP_SLAPD_V (ber_len_t) sockbuf_max_incoming_auth;
 LDAP_SLAPD_V (int)		slap_conn_max_pending;
 LDAP_SLAPD_V (int)		slap_conn_max_pending_auth;
+LDAP_SLAPD_V (int)		slap_conn_max_batch;
+LDAP_SLAPD_V (int)		slap_group_cache_max;
+LDAP_SLAPD_V (int)		slap_group_cache_ttl;
+LDAP_SLAPD_V (int)		slap_dn_cache_max;
 LDAP_SLAPD_V (int)		slap_max_filter_depth;
+LDAP_SLAPD_V (int)		slap_filter_compile;
 
 LDAP_SLAPD_V (slap_mask_t)	global_allows;
 LDAP_SLAPD_V (slap_mask_t)	global_disallows;
@@ -868,6 +868,34 @@ slap_send_ldap_result( Operation *op, SlapReply *rs )
 
 	rs->sr_type = REP_RESULT;
 
+	/* every write reports its outcome here, internal ones included;
+	 * writes in a backend transaction flush again when it commits */
+	if ( rs->sr_err == LDAP_SUCCESS ) {
+		switch ( op->o_tag ) {
+		case LDAP_REQ_ADD:
+		case LDAP_REQ_DELETE:
+		case LDAP_REQ_MODIFY:
+			slap_group_cache_invalidate( &op->o_req_ndn, 0 );
+			break;
+		case LDAP_REQ_MODRDN:
+			slap_group_cache_invalidate( &op->o_req_ndn, 1 );
+			/* negative results may be cached for the new names */
+			if ( slap_group_cache_max > 0 ) {
+				struct berval pdn, nnewDN;
+
+				if ( op->orr_nnewSup )
+					pdn = *op->orr_nnewSup;
+				else
+					dnParent( &op->o_req_ndn, &pdn );
+				build_new_dn( &nnewDN, &pdn, &op->orr_nnewrdn,
+					op->o_tmpmemctx );
+				slap_group_cache_invalidate( &nnewDN, 1 );
+				op->o_tmpfree( nnewDN.bv_val, op->o_tmpmemctx );
+			}
+			break;
+		}
+	}
+
 	/* Propagate Abandons so that cleanup callbacks can be processed */
 	if ( rs->sr_err == SLAPD_ABANDON || op->o_abandon )
 		goto abandon;
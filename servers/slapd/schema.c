@@ -165,3 +165,131 @@ schema_info( Entry **entry, const char **text )
 	*entry = e;
 	return LDAP_SUCCESS;
 }
+
+/* Read-mostly hash index of schema element names and OIDs.
+ *
+ * Each slot points at the name berval of an index record whose first
+ * member is that berval. Lookups take no lock. Changes are already
+ * serialized by the schema code (startup, or cn=config with the thread
+ * pool paused). A record is linked by one pointer store once it is
+ * complete, and removed ones are replaced by a tombstone. When a table
+ * has to grow or be purged of tombstones, a new table is built and
+ * published, and the old one is retired but kept until
+ * schema_hash_free() so a reader still holding it stays valid.
+ */
+struct SchemaHash {
+	unsigned	sh_mask;	/* slots - 1 */
+	unsigned	sh_live;	/* records */
+	unsigned	sh_used;	/* records and tombstones */
+	SchemaHash	*sh_retired;
+	struct berval	*sh_slots[1];
+};
+
+static struct berval schema_hash_tomb;
+
+#define	SCHEMA_HASH_MIN	64
+
+static unsigned
+schema_hash_name( struct berval *name )
+{
+	unsigned h = 2166136261U;
+	ber_len_t i;
+
+	for ( i = 0; i < name->bv_len; i++ ) {
+		h ^= TOLOWER( (unsigned char) name->bv_val[i] );
+		h *= 16777619U;
+	}
+	return h;
+}
+
+static void
+schema_hash_link( SchemaHash *sh, struct berval *name )
+{
+	unsigned i;
+
+	for ( i = schema_hash_name( name ) & sh->sh_mask;
+		sh->sh_slots[i] && sh->sh_slots[i] != &schema_hash_tomb;
+		i = ( i + 1 ) & sh->sh_mask )
+		;
+	if ( !sh->sh_slots[i] )
+		sh->sh_used++;
+	sh->sh_live++;
+	sh->sh_slots[i] = name;
+}
+
+void
+schema_hash_insert( SchemaHash **shp, struct berval *name )
+{
+	SchemaHash *sh = *shp;
+
+	/* keep at least a quarter of the slots empty */
+	if ( !sh || ( sh->sh_used + 1 ) * 4 > ( sh->sh_mask + 1 ) * 3 ) {
+		SchemaHash *nsh;
+		unsigned i, n = SCHEMA_HASH_MIN;
+
+		while ( n < ( sh ? sh->sh_live + 1 : 1 ) * 4 )
+			n <<= 1;
+		nsh = ch_calloc( 1, sizeof( SchemaHash ) +
+			( n - 1 ) * sizeof( struct berval * ));
+		nsh->sh_mask = n - 1;
+		if ( sh ) {
+			for ( i = 0; i <= sh->sh_mask; i++ ) {
+				if ( sh->sh_slots[i] && sh->sh_slots[i] != &schema_hash_tomb )
+					schema_hash_link( nsh, sh->sh_slots[i] );
+			}
+			nsh->sh_retired = sh;
+		}
+		*shp = sh = nsh;
+	}
+	schema_hash_link( sh, name );
+}
+
+void
+schema_hash_delete( SchemaHash **shp, struct berval *name )
+{
+	SchemaHash *sh = *shp;
+	unsigned i;
+
+	if ( !sh )
+		return;
+	for ( i = schema_hash_name( name ) & sh->sh_mask; sh->sh_slots[i];
+		i = ( i + 1 ) & sh->sh_mask )
+	{
+		if ( sh->sh_slots[i] == name ) {
+			sh->sh_slots[i] = &schema_hash_tomb;
+			sh->sh_live--;
+			return;
+		}
+	}
+}
+
+struct berval *
+schema_hash_find( SchemaHash *sh, struct berval *name )
+{
+	struct berval *bv;
+	unsigned i;
+
+	if ( !sh )
+		return NULL;
+	for ( i = schema_hash_name( name ) & sh->sh_mask;
+		( bv = sh->sh_slots[i] ) != NULL;
+		i = ( i + 1 ) & sh->sh_mask )
+	{
+		if ( bv->bv_len == name->bv_len && bv != &schema_hash_tomb &&
+			!strncasecmp( bv->bv_val, name->bv_val, name->bv_len ))
+			return bv;
+	}
+	return NULL;
+}
+
+void
+schema_hash_free( SchemaHash **shp )
+{
+	SchemaHash *sh, *next;
+
+	for ( sh = *shp; sh; sh = next ) {
+		next = sh->sh_retired;
+		ch_free( sh );
+	}
+	*shp = NULL;
+}
@@ -204,6 +204,7 @@ unsigned int index_substr_if_minlen = SLAP_INDEX_SUBSTR_IF_MINLEN_DEFAULT;
 unsigned int index_substr_if_maxlen = SLAP_INDEX_SUBSTR_IF_MAXLEN_DEFAULT;
 unsigned int index_substr_any_len = SLAP_INDEX_SUBSTR_ANY_LEN_DEFAULT;
 unsigned int index_substr_any_step = SLAP_INDEX_SUBSTR_ANY_STEP_DEFAULT;
+int index_substr_exact = 0;
 
 unsigned int index_intlen = SLAP_INDEX_INTLEN_DEFAULT;
 unsigned int index_intlen_strlen = SLAP_INDEX_INTLEN_STRLEN(
@@ -721,6 +722,49 @@ hashIter(
 	HASH_Final( HASHdigest, &ctx );
 }
 
+/* Longest substring key stored unhashed by index_substr_exact */
+#define SUBSTR_EXACT_KEYMAX	128
+
+/* Set key from HASHcontext and value:len. With index_substr_exact
+ * the key is the match type, the prefix and the value itself, so
+ * distinct substrings never share a key; overlong keys are hashed.
+ */
+static void
+substrKey(
+	HASH_CONTEXT *HASHcontext,
+	struct berval *prefix,
+	char pre,
+	unsigned char *value,
+	ber_len_t len,
+	struct berval *key,
+	void *ctx )
+{
+	ber_len_t plen = prefix ? prefix->bv_len : 0;
+
+	if ( index_substr_exact && plen + len + 2 <= SUBSTR_EXACT_KEYMAX ) {
+		char *p;
+
+		key->bv_len = plen + len + 2;
+		key->bv_val = p = ber_memalloc_x( key->bv_len + 1, ctx );
+		*p++ = pre;
+		if ( plen ) {
+			AC_MEMCPY( p, prefix->bv_val, plen );
+			p += plen;
+		}
+		*p++ = '\0';
+		AC_MEMCPY( p, value, len );
+		p[len] = '\0';
+	} else {
+		unsigned char HASHdigest[HASH_BYTES];
+		struct berval digest;
+
+		digest.bv_val = (char *)HASHdigest;
+		digest.bv_len = HASH_LEN;
+		hashIter( HASHcontext, HASHdigest, value, len );
+		ber_dupbv_x( key, &digest, ctx );
+	}
+}
+
 /* Index generation function: Attribute values -> index hash keys */
 int octetStringIndexer(
 	slap_mask_t use,
@@ -796,6 +840,38 @@ int octetStringFilter(
 	return LDAP_SUCCESS;
 }
 
+/* Return the first occurrence of needle in hay, or NULL. Candidate
+ * positions come from memchr on the first byte and are screened on
+ * the last byte before the full compare; starts too close to the
+ * end of hay to fit needle are never examined.
+ */
+static char *
+substrFind(
+	struct berval *hay,
+	struct berval *needle )
+{
+	ber_len_t n = needle->bv_len;
+	char *p, *end;
+
+	if ( n > hay->bv_len ) {
+		return NULL;
+	}
+
+	p = hay->bv_val;
+	end = hay->bv_val + ( hay->bv_len - n ) + 1;
+	while ( ( p = memchr( p, needle->bv_val[0], end - p ) ) != NULL ) {
+		if ( p[n-1] == needle->bv_val[n-1] &&
+			memcmp( p, needle->bv_val, n ) == 0 )
+		{
+			return p;
+		}
+		if ( ++p == end ) {
+			break;
+		}
+	}
+	return NULL;
+}
+
 static int
 octetStringSubstringsMatch(
 	int *matchp,
@@ -862,10 +938,8 @@ octetStringSubstringsMatch(
 
 	if ( sub->sa_any ) {
 		for ( i = 0; !BER_BVISNULL( &sub->sa_any[i] ); i++ ) {
-			ber_len_t idx;
 			char *p;
 
-retry:
 			if ( inlen > left.bv_len ) {
 				/* not enough length */
 				match = 1;
@@ -876,41 +950,15 @@ retry:
 				continue;
 			}
 
-			p = memchr( left.bv_val, *sub->sa_any[i].bv_val, left.bv_len );
+			p = substrFind( &left, &sub->sa_any[i] );
 
 			if( p == NULL ) {
 				match = 1;
 				goto done;
 			}
 
-			idx = p - left.bv_val;
-
-			if ( idx >= left.bv_len ) {
-				/* this shouldn't happen */
-				return LDAP_OTHER;
-			}
-
-			left.bv_val = p;
-			left.bv_len -= idx;
-
-			if ( sub->sa_any[i].bv_len > left.bv_len ) {
-				/* not enough left */
-				match = 1;
-				goto done;
-			}
-
-			match = memcmp( left.bv_val,
-				sub->sa_any[i].bv_val,
-				sub->sa_any[i].bv_len );
-
-			if ( match != 0 ) {
-				left.bv_val++;
-				left.bv_len--;
-				goto retry;
-			}
-
-			left.bv_val += sub->sa_any[i].bv_len;
-			left.bv_len -= sub->sa_any[i].bv_len;
+			left.bv_len -= ( p - left.bv_val ) + sub->sa_any[i].bv_len;
+			left.bv_val = p + sub->sa_any[i].bv_len;
 			inlen -= sub->sa_any[i].bv_len;
 		}
 	}
@@ -936,10 +984,6 @@ octetStringSubstringsIndexer(
 	BerVarray keys;
 
 	HASH_CONTEXT HCany, HCini, HCfin;
-	unsigned char HASHdigest[HASH_BYTES];
-	struct berval digest;
-	digest.bv_val = (char *)HASHdigest;
-	digest.bv_len = HASH_LEN;
 
 	nkeys = 0;
 
@@ -995,10 +1039,9 @@ octetStringSubstringsIndexer(
 			max = values[i].bv_len - (index_substr_any_len - 1);
 
 			for( j=0; j<max; j++ ) {
-				hashIter( &HCany, HASHdigest,
-					(unsigned char *)&values[i].bv_val[j],
-					index_substr_any_len );
-				ber_dupbv_x( &keys[nkeys++], &digest, ctx );
+				substrKey( &HCany, prefix, SLAP_INDEX_SUBSTR_PREFIX,
+					(unsigned char *)&values[i].bv_val[j], index_substr_any_len,
+					&keys[nkeys++], ctx );
 			}
 		}
 
@@ -1011,15 +1054,15 @@ octetStringSubstringsIndexer(
 		for( j=index_substr_if_minlen; j<=max; j++ ) {
 
 			if( flags & SLAP_INDEX_SUBSTR_INITIAL ) {
-				hashIter( &HCini, HASHdigest,
-					(unsigned char *)values[i].bv_val, j );
-				ber_dupbv_x( &keys[nkeys++], &digest, ctx );
+				substrKey( &HCini, prefix, SLAP_INDEX_SUBSTR_INITIAL_PREFIX,
+					(unsigned char *)values[i].bv_val, j,
+					&keys[nkeys++], ctx );
 			}
 
 			if( flags & SLAP_INDEX_SUBSTR_FINAL ) {
-				hashIter( &HCfin, HASHdigest,
-					(unsigned char *)&values[i].bv_val[values[i].bv_len-j], j );
-				ber_dupbv_x( &keys[nkeys++], &digest, ctx );
+				substrKey( &HCfin, prefix, SLAP_INDEX_SUBSTR_FINAL_PREFIX,
+					(unsigned char *)&values[i].bv_val[values[i].bv_len-j], j,
+					&keys[nkeys++], ctx );
 			}
 
 		}
@@ -1054,9 +1097,7 @@ octetStringSubstringsFilter (
 	size_t klen;
 	BerVarray keys;
 	HASH_CONTEXT HASHcontext;
-	unsigned char HASHdigest[HASH_BYTES];
 	struct berval *value;
-	struct berval digest;
 
 	sa = (SubstringsAssertion *) assertedValue;
 
@@ -1100,9 +1141,6 @@ octetStringSubstringsFilter (
 		return LDAP_SUCCESS;
 	}
 
-	digest.bv_val = (char *)HASHdigest;
-	digest.bv_len = HASH_LEN;
-
 	keys = slap_sl_malloc( sizeof( struct berval ) * (nkeys+1), ctx );
 	nkeys = 0;
 
@@ -1117,9 +1155,9 @@ octetStringSubstringsFilter (
 			? index_substr_if_maxlen : value->bv_len;
 
 		hashPreset( &HASHcontext, prefix, pre, syntax, mr );
-		hashIter( &HASHcontext, HASHdigest,
-			(unsigned char *)value->bv_val, klen );
-		ber_dupbv_x( &keys[nkeys++], &digest, ctx );
+		substrKey( &HASHcontext, prefix, pre,
+			(unsigned char *)value->bv_val, klen,
+			&keys[nkeys++], ctx );
 
 		/* If initial is too long and we have subany indexed, use it
 		 * to match the excess...
@@ -1131,9 +1169,9 @@ octetStringSubstringsFilter (
 			hashPreset( &HASHcontext, prefix, pre, syntax, mr);
 			for ( j=index_substr_if_maxlen-1; j <= value->bv_len - index_substr_any_len; j+=index_substr_any_step )
 			{
-				hashIter( &HASHcontext, HASHdigest,
-					(unsigned char *)&value->bv_val[j], index_substr_any_len );
-				ber_dupbv_x( &keys[nkeys++], &digest, ctx );
+				substrKey( &HASHcontext, prefix, pre,
+					(unsigned char *)&value->bv_val[j], index_substr_any_len,
+					&keys[nkeys++], ctx );
 			}
 		}
 	}
@@ -1155,9 +1193,9 @@ octetStringSubstringsFilter (
 				j <= value->bv_len - index_substr_any_len;
 				j += index_substr_any_step )
 			{
-				hashIter( &HASHcontext, HASHdigest,
-					(unsigned char *)&value->bv_val[j], klen ); 
-				ber_dupbv_x( &keys[nkeys++], &digest, ctx );
+				substrKey( &HASHcontext, prefix, pre,
+					(unsigned char *)&value->bv_val[j], klen,
+					&keys[nkeys++], ctx );
 			}
 		}
 	}
@@ -1173,9 +1211,9 @@ octetStringSubstringsFilter (
 			? index_substr_if_maxlen : value->bv_len;
 
 		hashPreset( &HASHcontext, prefix, pre, syntax, mr );
-		hashIter( &HASHcontext, HASHdigest,
-			(unsigned char *)&value->bv_val[value->bv_len-klen], klen );
-		ber_dupbv_x( &keys[nkeys++], &digest, ctx );
+		substrKey( &HASHcontext, prefix, pre,
+			(unsigned char *)&value->bv_val[value->bv_len-klen], klen,
+			&keys[nkeys++], ctx );
 
 		/* If final is too long and we have subany indexed, use it
 		 * to match the excess...
@@ -1187,9 +1225,9 @@ octetStringSubstringsFilter (
 			hashPreset( &HASHcontext, prefix, pre, syntax, mr);
 			for ( j=0; j <= value->bv_len - index_substr_if_maxlen; j+=index_substr_any_step )
 			{
-				hashIter( &HASHcontext, HASHdigest,
-					(unsigned char *)&value->bv_val[j], index_substr_any_len );
-				ber_dupbv_x( &keys[nkeys++], &digest, ctx );
+				substrKey( &HASHcontext, prefix, pre,
+					(unsigned char *)&value->bv_val[j], index_substr_any_len,
+					&keys[nkeys++], ctx );
 			}
 		}
 	}
@@ -1899,6 +1937,12 @@ UTF8StringNormalize(
 		return LDAP_INVALID_SYNTAX;
 	}
 	
+	/* nothing to collapse or trim */
+	if ( memchr( tmp.bv_val, ' ', tmp.bv_len ) == NULL ) {
+		*normalized = tmp;
+		return LDAP_SUCCESS;
+	}
+
 	/* collapse spaces (in place) */
 	nvalue.bv_len = 0;
 	nvalue.bv_val = tmp.bv_val;
@@ -1978,7 +2022,6 @@ directoryStringSubstringsMatch(
 
 	if ( sub->sa_any ) {
 		for ( i = 0; !BER_BVISNULL( &sub->sa_any[i] ); i++ ) {
-			ber_len_t idx;
 			char *p;
 
 			if( priorspace && !BER_BVISEMPTY( &sub->sa_any[i] ) 
@@ -1990,52 +2033,19 @@ directoryStringSubstringsMatch(
 			}
 			priorspace=0;
 
-retry:
 			if ( BER_BVISEMPTY( &sub->sa_any[i] ) ) {
 				continue;
 			}
 
-			if ( sub->sa_any[i].bv_len > left.bv_len ) {
-				/* not enough left */
-				match = 1;
-				goto done;
-			}
-
-			p = memchr( left.bv_val, *sub->sa_any[i].bv_val, left.bv_len );
+			p = substrFind( &left, &sub->sa_any[i] );
 
 			if( p == NULL ) {
 				match = 1;
 				goto done;
 			}
 
-			idx = p - left.bv_val;
-
-			if ( idx >= left.bv_len ) {
-				/* this shouldn't happen */
-				return LDAP_OTHER;
-			}
-
-			left.bv_val = p;
-			left.bv_len -= idx;
-
-			if ( sub->sa_any[i].bv_len > left.bv_len ) {
-				/* not enough left */
-				match = 1;
-				goto done;
-			}
-
-			match = memcmp( left.bv_val,
-				sub->sa_any[i].bv_val,
-				sub->sa_any[i].bv_len );
-
-			if ( match != 0 ) {
-				left.bv_val++;
-				left.bv_len--;
-				goto retry;
-			}
-
-			left.bv_val += sub->sa_any[i].bv_len;
-			left.bv_len -= sub->sa_any[i].bv_len;
+			left.bv_len -= ( p - left.bv_val ) + sub->sa_any[i].bv_len;
+			left.bv_val = p + sub->sa_any[i].bv_len;
 
 			priorspace = ASCII_SPACE(
 				sub->sa_any[i].bv_val[sub->sa_any[i].bv_len] );
@@ -140,9 +140,13 @@ LDAP_BEGIN_DECL
 
 #define SLAP_SB_MAX_INCOMING_DEFAULT ((1<<18) - 1)
 #define SLAP_SB_MAX_INCOMING_AUTH ((1<<24) - 1)
+#define SLAP_SB_MAX_READAHEAD	(1<<16)
 
 #define SLAP_CONN_MAX_PENDING_DEFAULT	100
 #define SLAP_CONN_MAX_PENDING_AUTH	1000
+#define SLAP_CONN_MAX_BATCH_DEFAULT	0
+#define SLAP_GROUP_CACHE_MAX_DEFAULT	0
+#define SLAP_DN_CACHE_MAX_DEFAULT	0
 #define SLAP_MAX_FILTER_DEPTH_DEFAULT	1000
 
 #define SLAP_TEXT_BUFLEN (256)
@@ -349,10 +353,12 @@ typedef struct AttributeType AttributeType;
 typedef struct AttributeDescription AttributeDescription;
 typedef struct AttributeName AttributeName;
 typedef struct ContentRule ContentRule;
+typedef struct SchemaHash SchemaHash;
 
 typedef struct AttributeAssertion AttributeAssertion;
 typedef struct SubstringsAssertion SubstringsAssertion;
 typedef struct Filter Filter;
+typedef struct FilterProg FilterProg;
 typedef struct ValuesReturnFilter ValuesReturnFilter;
 typedef struct Attribute Attribute;
 #ifdef LDAP_COMP_MATCH
@@ -1175,6 +1181,20 @@ struct Attribute {
 #endif
 };
 
+/*
+ * Optional open addressed table of an entry's attributes, keyed by
+ * ad_index, filled by entry_attr_index(). It is only trusted while
+ * the entry's attribute list still starts and ends where it did
+ * when the table was built.
+ */
+typedef struct AttrIndex {
+	Attribute	*ai_first;
+	Attribute	*ai_last;
+	unsigned	ai_mask;	/* number of slots - 1 */
+	int		ai_options;	/* some attribute has options */
+	Attribute	*ai_slots[1];
+} AttrIndex;
+
 
 /*
  * the id used in the indexes to refer to an entry
@@ -1208,6 +1228,7 @@ struct Entry {
 #define e_ndn e_nname.bv_val
 
 	Attribute	*e_attrs;	/* list of attributes + values */
+	AttrIndex	*e_attrindex;	/* optional lookup table for e_attrs */
 
 	slap_mask_t	e_ocflags;
 
@@ -1548,6 +1569,9 @@ typedef struct AccessControl {
 	struct AccessControl	*acl_next;
 } AccessControl;
 
+/* max number of rules of a database whose DN match is cached per entry */
+#define SLAP_ACL_DNCACHE	512
+
 typedef struct AccessControlState {
 	/* Access state */
 
@@ -1568,6 +1592,14 @@ typedef struct AccessControlState {
 
 	/* True if started to process frontend ACLs */
 	int as_fe_done;
+
+	/* Rules whose "to" DN part is known not to match as_dn_e,
+	 * indexed by position in the ACL walk; it survives changes
+	 * of as_desc since it only depends on the entry DN */
+	Entry *as_dn_e;
+	char *as_dn_ndn;
+	BackendDB *as_dn_bd;
+	unsigned char as_dn_miss[SLAP_ACL_DNCACHE / 8];
 } AccessControlState;
 #define ACL_STATE_INIT { NULL, ACL_NONE, NULL, 0, 0, ACL_PRIV_NONE, -1, 0 }
 
@@ -2569,6 +2601,10 @@ typedef struct slap_counters_t {
 	ldap_pvt_mp_t		sc_ops_initiated;
 	ldap_pvt_mp_t		sc_ops_completed_[SLAP_OP_LAST];
 	ldap_pvt_mp_t		sc_ops_initiated_[SLAP_OP_LAST];
+
+	ldap_pvt_mp_t		sc_acl_evals;	/* ACL list walks */
+	ldap_pvt_mp_t		sc_acl_rules;	/* rules whose DN was tested */
+	ldap_pvt_mp_t		sc_acl_skipped;	/* rules skipped by DN cache */
 } slap_counters_t;
 
 /*
@@ -2590,6 +2626,14 @@ typedef struct Opheader {
 
 	slap_counters_t	*oh_counters;
 
+	/* group cache generation when the op started, see fe_acl_group() */
+	unsigned long	oh_group_gen;
+
+	/* ACL work, added to oh_counters when the op completes */
+	unsigned long	oh_acl_evals;
+	unsigned long	oh_acl_rules;
+	unsigned long	oh_acl_skipped;
+
 	char		oh_log_prefix[ /* sizeof("conn= op=") + 2*LDAP_PVT_INTTYPE_CHARS(unsigned long) */ SLAP_TEXT_BUFLEN ];
 
 #ifdef LDAP_SLAPI
@@ -2831,6 +2875,7 @@ struct Operation {
 	LDAP_SLIST_HEAD(o_e, OpExtra) o_extra;	/* anything the backend needs */
 
 	LDAP_STAILQ_ENTRY(Operation)	o_next;	/* next operation in list */
+	struct Operation	*o_bnext;	/* next operation in input batch */
 };
 
 typedef struct OperationBuffer {
@@ -2839,6 +2884,25 @@ typedef struct OperationBuffer {
 	void		*ob_controls[SLAP_MAX_CIDS];
 } OperationBuffer;
 
+typedef struct slap_op_pool_stats_t {
+	unsigned long	ps_allocated;	/* operations carved from slabs */
+	unsigned long	ps_reused;	/* taken from the shared pool */
+	unsigned long	ps_pooled;	/* currently idle in the shared pool */
+} slap_op_pool_stats_t;
+
+typedef struct slap_group_cache_stats_t {
+	unsigned long	gs_hits;
+	unsigned long	gs_misses;
+	unsigned long	gs_invalidated;	/* results dropped by writes */
+	unsigned long	gs_entries;	/* results currently cached */
+} slap_group_cache_stats_t;
+
+typedef struct slap_dn_cache_stats_t {
+	unsigned long	ds_hits;
+	unsigned long	ds_misses;
+	unsigned long	ds_entries;
+} slap_dn_cache_stats_t;
+
 #define send_ldap_error( op, rs, err, text ) do { \
 		(rs)->sr_err = err; (rs)->sr_text = text; \
 		((op)->o_conn->c_send_ldap_result)( op, rs ); \
@@ -705,8 +705,6 @@ slap_tool_init(
 	}
 #endif
 
-	at_oc_cache = 1;
-
 	switch ( tool ) {
 	case SLAPADD:
 	case SLAPCAT:
@@ -66,6 +66,22 @@ struct nonpresent_entry {
 	LDAP_LIST_ENTRY(nonpresent_entry) npe_link;
 };
 
+/* Delta-sync catch-up: changes read ahead of the one being applied */
+typedef struct sync_coalesce {
+	LDAPMessage *co_next;		/* read ahead but not merged */
+	struct sync_cookie *co_cookie;	/* cookie of the last merged change */
+	int co_slot;			/* pending CSN slot held by the caller */
+} sync_coalesce;
+
+/* Upper bound on the changes merged into one operation */
+#define SYNC_COALESCE_MAX	1024
+
+/* Modifies resolved by CSN ordering, per pair of serverIDs */
+typedef struct conflict_count {
+	int cf_sids;		/* older sid << 12 | newer sid */
+	unsigned long cf_count;
+} conflict_count;
+
 typedef struct cookie_vals {
 	struct berval *cv_vals;
 	int *cv_sids;
@@ -156,12 +172,21 @@ typedef struct syncinfo_s {
 	int			si_syncdata;
 	int			si_logstate;
 	int			si_lazyCommit;
+	time_t			si_catchup;	/* coalesce changes older than this */
+	int			si_refreshbatch;	/* refresh entries per backend txn */
+	int			si_txn_cnt;	/* entries in the open batch */
+	OpExtra			*si_txn;	/* open refresh batch */
+	char			*si_txn_uuids;	/* presentlist insertions of the batch */
+	int			si_txn_nuuids;
+	int			si_txn_maxuuids;
+	unsigned long		si_txn_entries;	/* refresh counts of the batch */
+	unsigned long		si_txn_present;
 	int			si_got;
 	int			si_strict_refresh;	/* stop listening during fallback refresh */
 	int			si_too_old;
 	int			si_is_configdb;
 	ber_int_t	si_msgid;
-	Avlnode			*si_presentlist;
+	struct presentbucket	*si_presentlist;
 	LDAP			*si_ld;
 	Connection		*si_conn;
 	LDAP_LIST_HEAD(np, nonpresent_entry)	si_nonpresentlist;
@@ -177,6 +202,12 @@ typedef struct syncinfo_s {
 	int		si_monitorInited;
 	time_t	si_lastconnect;
 	time_t	si_lastcontact;
+	time_t	si_refreshStart;
+	unsigned long	si_refreshEntries;	/* entries received in refresh */
+	unsigned long	si_refreshPresentCnt;	/* UUIDs reported present */
+	unsigned long	si_conflictsTotal;
+	conflict_count	*si_conflicts;	/* sorted by cf_sids */
+	int		si_numconflicts;
 	struct berval	si_connaddr;
 	struct berval	si_lastCookieRcvd;
 	struct berval	si_lastCookieSent;
@@ -187,14 +218,15 @@ typedef struct syncinfo_s {
 	ldap_pvt_thread_mutex_t	si_mutex;
 } syncinfo_t;
 
-static int syncuuid_cmp( const void *, const void * );
 static int presentlist_insert( syncinfo_t* si, struct berval *syncUUID );
-static void presentlist_delete( Avlnode **av, struct berval *syncUUID );
-static char *presentlist_find( Avlnode *av, struct berval *syncUUID );
-static int presentlist_free( Avlnode *av );
+static void presentlist_delete( struct presentbucket *pl, struct berval *syncUUID );
+static int presentlist_find( struct presentbucket *pl, struct berval *syncUUID );
+static int presentlist_free( struct presentbucket *pl );
+static void syncrepl_txn_undo( syncinfo_t *si );
 static void syncrepl_del_nonpresent( Operation *, syncinfo_t *, BerVarray, struct sync_cookie *, int );
 static int syncrepl_message_to_op(
-					syncinfo_t *, Operation *, LDAPMessage *, int );
+					syncinfo_t *, Operation *, LDAPMessage *, int,
+					sync_coalesce * );
 static int syncrepl_message_to_entry(
 					syncinfo_t *, Operation *, LDAPMessage *,
 					Modifications **, Entry **, int, struct berval* );
@@ -766,6 +798,11 @@ ldap_sync_search(
 	si->si_refreshDone = 0;
 	si->si_refreshPresent = 0;
 	si->si_refreshDelete = 0;
+	ldap_pvt_thread_mutex_lock( &si->si_monitor_mutex );
+	si->si_refreshStart = slap_get_time();
+	si->si_refreshEntries = 0;
+	si->si_refreshPresentCnt = 0;
+	ldap_pvt_thread_mutex_unlock( &si->si_monitor_mutex );
 
 	rc = ldap_search_ext( si->si_ld, base, scope, filter, attrs, attrsonly,
 		ctrls, NULL, NULL, si->si_slimit, &si->si_msgid );
@@ -1215,24 +1252,20 @@ compare_csns( struct sync_cookie *sc1, struct sync_cookie *sc2, int *which )
 	}
 
 	for (j=0; j<sc2->numcsns; j++) {
-		for (i=0; i<sc1->numcsns; i++) {
-			if ( sc1->sids[i] != sc2->sids[j] )
-				continue;
-			value_match( &match, slap_schema.si_ad_entryCSN,
-				slap_schema.si_ad_entryCSN->ad_type->sat_ordering,
-				SLAP_MR_VALUE_OF_ATTRIBUTE_SYNTAX,
-				&sc1->ctxcsn[i], &sc2->ctxcsn[j], &text );
-			if ( match < 0 ) {
-				*which = j;
-				return match;
-			}
-			break;
-		}
-		if ( i == sc1->numcsns ) {
+		i = slap_csn_sid_slot( sc1->sids, sc1->numcsns, sc2->sids[j] );
+		if ( i == sc1->numcsns || sc1->sids[i] != sc2->sids[j] ) {
 			/* sc2 has a sid sc1 lacks */
 			*which = j;
 			return -1;
 		}
+		value_match( &match, slap_schema.si_ad_entryCSN,
+			slap_schema.si_ad_entryCSN->ad_type->sat_ordering,
+			SLAP_MR_VALUE_OF_ATTRIBUTE_SYNTAX,
+			&sc1->ctxcsn[i], &sc2->ctxcsn[j], &text );
+		if ( match < 0 ) {
+			*which = j;
+			return match;
+		}
 	}
 	return match;
 }
@@ -1252,24 +1285,19 @@ check_csn_age(
 {
 	int i, rc = CV_SID_NEW;
 
-	for ( i =0; i<cv->cv_num; i++ ) {
+	i = slap_csn_sid_slot( cv->cv_sids, cv->cv_num, sid );
+	if ( i < cv->cv_num && cv->cv_sids[i] == sid ) {
 #ifdef CHATTY_SYNCLOG
 		Debug( LDAP_DEBUG_SYNC, "do_syncrep2: %s CSN for sid %d: %s\n",
 			si->si_ridtxt, i, cv->cv_vals[i].bv_val );
 #endif
-		/* new SID */
-		if ( sid < cv->cv_sids[i] )
-			break;
-		if ( cv->cv_sids[i] == sid ) {
-			if ( ber_bvcmp( csn, &cv->cv_vals[i] ) <= 0 ) {
-				dn->bv_val[dn->bv_len] = '\0';
-				Debug( LDAP_DEBUG_SYNC, "do_syncrep2: %s CSN too old, ignoring %s (%s)\n",
-					si->si_ridtxt, csn->bv_val, dn->bv_val );
-				return CV_CSN_OLD;
-			}
-			rc = CV_CSN_OK;
-			break;
+		if ( ber_bvcmp( csn, &cv->cv_vals[i] ) <= 0 ) {
+			dn->bv_val[dn->bv_len] = '\0';
+			Debug( LDAP_DEBUG_SYNC, "do_syncrep2: %s CSN too old, ignoring %s (%s)\n",
+				si->si_ridtxt, csn->bv_val, dn->bv_val );
+			return CV_CSN_OLD;
 		}
+		rc = CV_CSN_OK;
 	}
 	if ( slot )
 		*slot = i;
@@ -1296,6 +1324,107 @@ get_pmutex(
 	return 0;
 }
 
+/*
+ * Refresh entries may be written in batches, each in one backend
+ * transaction. Only plain refresh entries that carry no cookie go into
+ * a batch, in the order they are received, so a parent is still
+ * written before its children. Any other message commits the batch
+ * first, so a cookie is never saved ahead of the entries it covers. The
+ * batch is also committed before waiting for the provider or for the
+ * pending CSN mutex, so the backend's write lock is never held while
+ * blocked on either.
+ */
+static int
+syncrepl_txn_ok(
+	syncinfo_t *si )
+{
+	/* overlays may serialize writes on locks of their own */
+	return si->si_refreshbatch > 1 &&
+		si->si_wbe->bd_info->bi_op_txn &&
+		!overlay_is_over( si->si_wbe );
+}
+
+static int
+syncrepl_txn_begin(
+	syncinfo_t *si,
+	Operation *op )
+{
+	BackendDB *be = op->o_bd;
+	int rc;
+
+	op->o_bd = si->si_wbe;
+	rc = op->o_bd->bd_info->bi_op_txn( op, SLAP_TXN_BEGIN, &si->si_txn );
+	op->o_bd = be;
+	if ( rc ) {
+		Debug( LDAP_DEBUG_ANY, "syncrepl_txn_begin: %s "
+			"couldn't start DB transaction (%d)\n",
+			si->si_ridtxt, rc );
+		if ( si->si_txn ) {
+			LDAP_SLIST_REMOVE( &op->o_extra, si->si_txn, OpExtra, oe_next );
+			op->o_tmpfree( si->si_txn, op->o_tmpmemctx );
+			si->si_txn = NULL;
+		}
+	}
+	si->si_txn_cnt = 0;
+	si->si_txn_nuuids = 0;
+	si->si_txn_entries = 0;
+	si->si_txn_present = 0;
+	return rc;
+}
+
+static int
+syncrepl_txn_end(
+	syncinfo_t *si,
+	Operation *op,
+	int commit )
+{
+	BackendDB *be = op->o_bd;
+	int rc;
+
+	if ( !si->si_txn )
+		return LDAP_SUCCESS;
+
+	LDAP_SLIST_REMOVE( &op->o_extra, si->si_txn, OpExtra, oe_next );
+	op->o_bd = si->si_wbe;
+	rc = op->o_bd->bd_info->bi_op_txn( op,
+		commit ? SLAP_TXN_COMMIT : SLAP_TXN_ABORT, &si->si_txn );
+	op->o_bd = be;
+	si->si_txn = NULL;
+	if ( rc ) {
+		Debug( LDAP_DEBUG_ANY, "syncrepl_txn_end: %s "
+			"commit of %d entries failed (%d)\n",
+			si->si_ridtxt, si->si_txn_cnt, rc );
+		rc = LDAP_OTHER;
+	} else if ( commit ) {
+		/* results were sent before the writes became visible */
+		slap_group_cache_flush();
+	}
+	if ( rc || !commit )
+		syncrepl_txn_undo( si );
+	return rc;
+}
+
+/* Commit an open batch before blocking for the next message */
+static int
+syncrepl_result(
+	syncinfo_t *si,
+	Operation *op,
+	struct timeval *tout,
+	LDAPMessage **msg )
+{
+	if ( si->si_txn ) {
+		struct timeval poll = { 0, 0 };
+		int rc = ldap_result( si->si_ld, si->si_msgid, LDAP_MSG_ONE,
+			&poll, msg );
+
+		if ( rc != 0 )
+			return rc;
+		if ( syncrepl_txn_end( si, op, 1 ))
+			return -1;
+	}
+	return ldap_result( si->si_ld, si->si_msgid, LDAP_MSG_ONE, tout, msg );
+}
+
 static int
 do_syncrep2(
 	Operation *op,
@@ -1319,6 +1448,7 @@ do_syncrep2(
 	struct timeval tout = { 0, 0 };
 
 	int		refreshDeletes = 0;
+	sync_coalesce	co = { NULL };
 	int		refreshing = !si->si_refreshDone &&
 			!( si->si_syncdata && si->si_logstate == SYNCLOG_LOGGING );
 	char empty[6] = "empty";
@@ -1342,8 +1472,9 @@ do_syncrep2(
 		tout.tv_sec = si->si_bindconf.sb_timeout_api;
 	}
 
-	while ( ( rc = ldap_result( si->si_ld, si->si_msgid, LDAP_MSG_ONE,
-		&tout, &msg ) ) > 0 )
+	/* a message read ahead during catch-up goes first */
+	while ( ( msg = co.co_next ) != NULL ||
+		( rc = syncrepl_result( si, op, &tout, &msg ) ) > 0 )
 	{
 		int				match, punlock, syncstate;
 		struct berval	*retdata, syncUUID[2], cookie = BER_BVNULL;
@@ -1355,10 +1486,14 @@ do_syncrep2(
 		Entry			*entry;
 		struct berval	bdn;
 
+		co.co_next = NULL;
 		if ( slapd_shutdown ) {
 			rc = SYNC_SHUTDOWN;
 			goto done;
 		}
+		if ( si->si_txn && ldap_msgtype( msg ) != LDAP_RES_SEARCH_ENTRY &&
+			( rc = syncrepl_txn_end( si, op, 1 )))
+			goto done;
 		si->si_lastcontact = slap_get_time();
 		switch( ldap_msgtype( msg ) ) {
 		case LDAP_RES_SEARCH_ENTRY:
@@ -1385,7 +1520,7 @@ do_syncrep2(
 			}
 			if ( si->si_syncdata == SYNCDATA_CHANGELOG ) {
 				if ( si->si_logstate == SYNCLOG_LOGGING ) {
-					rc = syncrepl_message_to_op( si, op, msg, 1 );
+					rc = syncrepl_message_to_op( si, op, msg, 1, NULL );
 					if ( rc )
 						goto logerr;
 					if ( si->si_type == LDAP_SYNC_REFRESH_AND_PERSIST && rctrls ) {
@@ -1465,6 +1600,10 @@ do_syncrep2(
 				goto done;
 			}
 			if ( ber_peek_tag( ber, &len ) == LDAP_TAG_SYNC_COOKIE ) {
+				if ( si->si_txn && ( rc = syncrepl_txn_end( si, op, 1 ))) {
+					ldap_controls_free( rctrls );
+					goto done;
+				}
 				if ( ber_scanf( ber, /*"{"*/ "m}", &cookie ) != LBER_ERROR ) {
 
 				Debug( LDAP_DEBUG_SYNC, "do_syncrep2: %s cookie=%s\n",
@@ -1532,7 +1671,10 @@ do_syncrep2(
 			rc = 0;
 			if ( si->si_syncdata && si->si_logstate == SYNCLOG_LOGGING ) {
 				modlist = NULL;
-				if ( ( rc = syncrepl_message_to_op( si, op, msg, punlock < 0 ) ) == LDAP_SUCCESS &&
+				co.co_cookie = &syncCookie;
+				co.co_slot = punlock;
+				if ( ( rc = syncrepl_message_to_op( si, op, msg, punlock < 0,
+						( si->si_catchup && punlock >= 0 ) ? &co : NULL ) ) == LDAP_SUCCESS &&
 					syncCookie.ctxcsn )
 				{
 					rc = syncrepl_updateCookie( si, op, &syncCookie, 0 );
@@ -1561,16 +1703,35 @@ logerr:
 			} else if ( ( rc = syncrepl_message_to_entry( si, op, msg,
 				&modlist, &entry, syncstate, syncUUID ) ) == LDAP_SUCCESS )
 			{
+				int batch = punlock < 0 && !si->si_refreshDone &&
+					syncrepl_txn_ok( si );
+
+				if ( !batch && si->si_txn &&
+					( rc = syncrepl_txn_end( si, op, 1 )))
+					goto done;
 				if ( punlock < 0 ) {
-					if (( rc = get_pmutex( si )))
+					if ( si->si_txn && ldap_pvt_thread_mutex_trylock(
+						&si->si_cookieState->cs_pmutex ) &&
+						( rc = syncrepl_txn_end( si, op, 1 )))
+						goto done;
+					if ( !si->si_txn && ( rc = get_pmutex( si )))
 						goto done;
 				}
+				if ( batch && !si->si_txn )
+					(void)syncrepl_txn_begin( si, op );
 				if ( ( rc = syncrepl_entry( si, op, entry, &modlist,
 					syncstate, syncUUID, syncCookie.ctxcsn ) ) == LDAP_SUCCESS &&
 					syncCookie.ctxcsn )
 				{
 					rc = syncrepl_updateCookie( si, op, &syncCookie, 0 );
 				}
+				if ( si->si_txn ) {
+					/* the refresh restarts from the last saved cookie */
+					if ( rc != LDAP_SUCCESS )
+						syncrepl_txn_end( si, op, 0 );
+					else if ( ++si->si_txn_cnt >= si->si_refreshbatch )
+						rc = syncrepl_txn_end( si, op, 1 );
+				}
 				if ( punlock < 0 )
 					ldap_pvt_thread_mutex_unlock( &si->si_cookieState->cs_pmutex );
 			}
@@ -1900,6 +2061,9 @@ logerr:
 								(void)presentlist_insert( si, &syncUUIDs[i] );
 								slap_sl_free( syncUUIDs[i].bv_val, op->o_tmpmemctx );
 							}
+							ldap_pvt_thread_mutex_lock( &si->si_monitor_mutex );
+							si->si_refreshPresentCnt += i;
+							ldap_pvt_thread_mutex_unlock( &si->si_monitor_mutex );
 							slap_sl_free( syncUUIDs, op->o_tmpmemctx );
 						}
 					}
@@ -1975,7 +2139,10 @@ logerr:
 		}
 		ldap_msgfree( msg );
 		msg = NULL;
-		if ( ldap_pvt_thread_pool_pausing( &connection_pool )) {
+		/* can't hand a read ahead message back to libldap */
+		if ( !co.co_next && ldap_pvt_thread_pool_pausing( &connection_pool )) {
+			if ( si->si_txn && ( rc = syncrepl_txn_end( si, op, 1 )))
+				goto done;
 			slap_sync_cookie_free( &syncCookie, 0 );
 			slap_sync_cookie_free( &syncCookie_req, 0 );
 			return SYNC_PAUSED;
@@ -1989,6 +2156,9 @@ logerr:
 	}
 
 done:
+	if ( si->si_txn && syncrepl_txn_end( si, op, 1 ) &&
+		rc != SYNC_SHUTDOWN )
+		rc = LDAP_OTHER;
 	if ( err != LDAP_SUCCESS ) {
 		Debug( LDAP_DEBUG_ANY,
 			"do_syncrep2: %s (%d) %s\n",
@@ -2002,6 +2172,7 @@ done:
 	slap_sync_cookie_free( &syncCookie_req, 0 );
 
 	if ( msg ) ldap_msgfree( msg );
+	if ( co.co_next ) ldap_msgfree( co.co_next );
 
 	if ( rc ) {
 		if ( rc == LDAP_SYNC_REFRESH_REQUIRED && si->si_logstate == SYNCLOG_LOGGING && si->si_ld )
@@ -2349,11 +2520,11 @@ syncrepl_accesslog_mods(
 {
 	char *colon;
 	const char *text;
-	AttributeDescription *ad;
-	struct berval bv, bv2;
+	AttributeDescription *ad, *prevad = NULL;
+	struct berval bv, bv2, prevname = BER_BVNULL;
 	short op;
 	Modifications *mod = NULL, *modlist = NULL, **modtail;
-	int i, rc = 0;
+	int i, rc = 0, maxvals = 0;
 
 	modtail = &modlist;
 
@@ -2373,28 +2544,39 @@ syncrepl_accesslog_mods(
 		}
 
 		bv.bv_len = colon - bv.bv_val;
-		if ( slap_bv2ad( &bv, &ad, &text ) ) {
-			/* Invalid */
-			Debug( LDAP_DEBUG_ANY, "syncrepl_accesslog_mods: %s "
-				"Invalid attribute %s, %s\n",
-				si->si_ridtxt, bv.bv_val, text );
-			slap_mods_free( modlist, 1 );
-			modlist = NULL;
-			rc = -1;
-			break;
-		}
 
-		/* Ignore dynamically generated attrs */
-		if ( ad->ad_type->sat_flags & SLAP_AT_DYNAMIC ) {
-			continue;
-		}
+		/* Large modifications repeat the same attribute name on
+		 * every value; only look it up when it changes */
+		if ( bv.bv_len == prevname.bv_len &&
+			!memcmp( bv.bv_val, prevname.bv_val, bv.bv_len ) ) {
+			ad = prevad;
+		} else {
+			if ( slap_bv2ad( &bv, &ad, &text ) ) {
+				/* Invalid */
+				Debug( LDAP_DEBUG_ANY, "syncrepl_accesslog_mods: %s "
+					"Invalid attribute %s, %s\n",
+					si->si_ridtxt, bv.bv_val, text );
+				slap_mods_free( modlist, 1 );
+				modlist = NULL;
+				rc = -1;
+				break;
+			}
+			prevname = bv;
 
-		/* Ignore excluded attrs */
-		if ( ldap_charray_inlist( si->si_exattrs,
-			ad->ad_type->sat_cname.bv_val ) )
-		{
-			continue;
+			/* Ignore dynamically generated attrs */
+			if ( ad->ad_type->sat_flags & SLAP_AT_DYNAMIC ) {
+				ad = NULL;
+
+			/* Ignore excluded attrs */
+			} else if ( ldap_charray_inlist( si->si_exattrs,
+				ad->ad_type->sat_cname.bv_val ) )
+			{
+				ad = NULL;
+			}
+			prevad = ad;
 		}
+		if ( ad == NULL )
+			continue;
 
 		switch(colon[1]) {
 		case '+':	op = LDAP_MOD_ADD; break;
@@ -2414,6 +2596,7 @@ syncrepl_accesslog_mods(
 			mod->sml_values = NULL;
 			mod->sml_nvalues = NULL;
 			mod->sml_numvals = 0;
+			maxvals = 0;
 
 			if ( is_at_single_value( ad->ad_type ) ) {
 				if ( op == LDAP_MOD_ADD ) {
@@ -2433,8 +2616,15 @@ syncrepl_accesslog_mods(
 			bv.bv_val = colon + 3;
 			bv.bv_len = vals[i].bv_len - ( bv.bv_val - vals[i].bv_val );
 			REWRITE_VAL( si, ad, bv, bv2 );
-			ber_bvarray_add( &mod->sml_values, &bv2 );
-			mod->sml_numvals++;
+			/* grow geometrically, ber_bvarray_add would realloc
+			 * on every value */
+			if ( mod->sml_numvals + 1 >= maxvals ) {
+				maxvals = maxvals ? maxvals * 2 : 8;
+				mod->sml_values = ch_realloc( mod->sml_values,
+					maxvals * sizeof( struct berval ) );
+			}
+			mod->sml_values[ mod->sml_numvals++ ] = bv2;
+			BER_BVZERO( &mod->sml_values[ mod->sml_numvals ] );
 		}
 	}
 	*modres = modlist;
@@ -2801,6 +2991,40 @@ syncrepl_modify_cb( Operation *op, SlapReply *rs )
 	return SLAP_CB_CONTINUE;
 }
 
+/* A change from sid older lost to one from sid newer on CSN order */
+static void
+syncrepl_count_conflict( syncinfo_t *si, int older, int newer )
+{
+	int key, lo = 0, hi;
+
+	if ( older < 0 || newer < 0 )
+		return;
+	key = ( older << 12 ) | newer;
+
+	ldap_pvt_thread_mutex_lock( &si->si_monitor_mutex );
+	hi = si->si_numconflicts;
+	while ( lo < hi ) {
+		int mid = ( lo + hi ) >> 1;
+
+		if ( si->si_conflicts[mid].cf_sids < key )
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	if ( lo == si->si_numconflicts || si->si_conflicts[lo].cf_sids != key ) {
+		si->si_conflicts = ch_realloc( si->si_conflicts,
+			( si->si_numconflicts + 1 ) * sizeof( conflict_count ));
+		AC_MEMCPY( &si->si_conflicts[lo+1], &si->si_conflicts[lo],
+			( si->si_numconflicts - lo ) * sizeof( conflict_count ));
+		si->si_conflicts[lo].cf_sids = key;
+		si->si_conflicts[lo].cf_count = 0;
+		si->si_numconflicts++;
+	}
+	si->si_conflicts[lo].cf_count++;
+	si->si_conflictsTotal++;
+	ldap_pvt_thread_mutex_unlock( &si->si_monitor_mutex );
+}
+
 static int
 syncrepl_op_modify( Operation *op, SlapReply *rs )
 {
@@ -2808,7 +3032,7 @@ syncrepl_op_modify( Operation *op, SlapReply *rs )
 	OpExtra *oex;
 	syncinfo_t *si;
 	Entry *e, *e_dup;
-	int rc, match = 0;
+	int rc, match = 0, esid = -1;
 	Modifications *mod, *newlist;
 
 	LDAP_SLIST_FOREACH( oex, &op->o_extra, oe_next ) {
@@ -2857,6 +3081,7 @@ syncrepl_op_modify( Operation *op, SlapReply *rs )
 				slap_schema.si_ad_entryCSN->ad_type->sat_ordering,
 				SLAP_MR_VALUE_OF_ATTRIBUTE_SYNTAX,
 				&mod->sml_nvalues[0], &a->a_nvals[0], &text );
+			esid = slap_parse_csn_sid( &a->a_nvals[0] );
 		} else {
 			/* no entryCSN? shouldn't happen. assume mod is newer. */
 			match = 1;
@@ -2920,6 +3145,9 @@ syncrepl_op_modify( Operation *op, SlapReply *rs )
         Filter lf[3] = {0};
         AttributeAssertion aa[2] = {0};
 
+		syncrepl_count_conflict( si,
+			slap_parse_csn_sid( &mod->sml_nvalues[0] ), esid );
+
 		rx.rx_si = si;
 		rx.rx_entry = e_dup;
 		rx.rx_mods = newlist;
@@ -3031,12 +3259,191 @@ syncrepl_null_callback(
 	return LDAP_SUCCESS;
 }
 
+/* Is this change older than the catchup threshold? */
+static int
+syncrepl_catching_up( syncinfo_t *si, struct berval *csn )
+{
+	struct tm tm;
+	char tmbuf[ LDAP_LUTIL_GENTIME_BUFSIZE ];
+	time_t t = slap_get_time() - si->si_catchup;
+
+	ldap_pvt_gmtime( &t, &tm );
+	lutil_gentime( tmbuf, sizeof( tmbuf ), &tm );
+
+	/* both start with YYYYmmddHHMMSS */
+	return csn->bv_len > STRLENOF( "YYYYmmddHHMMSS" ) &&
+		memcmp( csn->bv_val, tmbuf, STRLENOF( "YYYYmmddHHMMSS" ) ) < 0;
+}
+
+/*
+ * Try to merge the change in msg into the modify in op. Returns 0 if
+ * it was merged (and msg can be freed), nonzero if it has to be
+ * applied on its own.
+ */
+static int
+syncrepl_coalesce_msg(
+	syncinfo_t	*si,
+	Operation	*op,
+	LDAPMessage	*msg,
+	Modifications	**modlist,
+	sync_coalesce	*co )
+{
+	BerElementBuffer berbuf;
+	BerElement	*ber = (BerElement *)&berbuf, *eber = NULL;
+	LDAPControl	**rctrls = NULL, *rctrlp = NULL;
+	struct sync_cookie	cookie = { NULL };
+	struct berval	bdn, bv, bv2, *bvals = NULL, *modvals = NULL,
+		cookiebv = BER_BVNULL, uuid, csn = BER_BVNULL,
+		dn = BER_BVNULL, ndn = BER_BVNULL;
+	ber_tag_t	tag = LBER_DEFAULT;
+	ber_len_t	len;
+	Modifications	*ml = NULL, **mlp;
+	int		rc = 1, i, syncstate, sid;
+
+	if ( ldap_msgtype( msg ) != LDAP_RES_SEARCH_ENTRY )
+		return 1;
+
+	/* only changes that advance the cookie we're holding */
+	ldap_get_entry_controls( si->si_ld, msg, &rctrls );
+	if ( rctrls )
+		rctrlp = ldap_control_find( LDAP_CONTROL_SYNC_STATE, rctrls, NULL );
+	if ( !rctrlp )
+		goto done;
+	ber_init2( ber, &rctrlp->ldctl_value, LBER_USE_DER );
+	if ( ber_scanf( ber, "{em" /*"}"*/, &syncstate, &uuid ) == LBER_ERROR ||
+		ber_peek_tag( ber, &len ) != LDAP_TAG_SYNC_COOKIE ||
+		ber_scanf( ber, /*"{"*/ "m}", &cookiebv ) == LBER_ERROR ||
+		BER_BVISNULL( &cookiebv ) )
+		goto done;
+	ber_dupbv( &cookie.octet_str, &cookiebv );
+	slap_parse_sync_cookie( &cookie, NULL );
+	if ( !cookie.ctxcsn )
+		goto done;
+	sid = slap_parse_csn_sid( cookie.ctxcsn );
+	if ( sid != si->si_cookieState->cs_psids[co->co_slot] ||
+		ber_bvcmp( cookie.ctxcsn,
+			&si->si_cookieState->cs_pvals[co->co_slot] ) <= 0 )
+		goto done;
+
+	if ( ldap_get_dn_ber( si->si_ld, msg, &eber, &bdn ) != LDAP_SUCCESS )
+		goto done;
+	while ( ldap_get_attribute_ber( si->si_ld, msg, eber, &bv, &bvals )
+		== LDAP_SUCCESS && bv.bv_val != NULL )
+	{
+		if ( !ber_bvstrcasecmp( &bv, &accesslog_sc.ls_dn ) ) {
+			if ( BER_BVISNULL( &ndn ) ) {
+				REWRITE_DN( si, bvals[0], bv2, dn, ndn );
+				if ( rc != LDAP_SUCCESS ) {
+					rc = 1;
+					BER_BVZERO( &ndn );
+				}
+			}
+		} else if ( !ber_bvstrcasecmp( &bv, &accesslog_sc.ls_req ) ) {
+			i = verb_to_mask( bvals[0].bv_val, modops );
+			if ( i >= 0 )
+				tag = modops[i].mask;
+		} else if ( !ber_bvstrcasecmp( &bv, &accesslog_sc.ls_mod ) ) {
+			modvals = bvals;
+			continue;
+		} else if ( !ber_bvstrcasecmp( &bv, &accesslog_sc.ls_controls ) ) {
+			/* leave anything unusual to syncrepl_message_to_op */
+			tag = LBER_DEFAULT;
+			ch_free( bvals );
+			break;
+		} else if ( !ber_bvstrcasecmp( &bv,
+			&slap_schema.si_ad_entryCSN->ad_cname ) )
+		{
+			csn = bvals[0];
+		}
+		ch_free( bvals );
+	}
+	rc = 1;
+
+	if ( BER_BVISNULL( &ndn ) || !dn_match( &ndn, &op->o_req_ndn ) ||
+		BER_BVISNULL( &csn ))
+		goto done;
+	if ( tag == LDAP_REQ_MODIFY ) {
+		if ( !modvals || syncrepl_accesslog_mods( si, modvals, &ml ) || !ml )
+			goto done;
+		for ( mlp = modlist; *mlp; mlp = &(*mlp)->sml_next )
+			;
+		*mlp = ml;
+	} else if ( tag == LDAP_REQ_DELETE ) {
+		/* the modifies so far don't matter anymore */
+		slap_mods_free( *modlist, 1 );
+		*modlist = NULL;
+		op->o_tag = LDAP_REQ_DELETE;
+	} else {
+		goto done;
+	}
+	rc = 0;
+
+	/* the merged operation now carries this change's CSN */
+	slap_graduate_commit_csn( op );
+	slap_queue_csn( op, &csn );
+	ber_bvreplace( &si->si_cookieState->cs_pvals[co->co_slot],
+		cookie.ctxcsn );
+	slap_sync_cookie_free( co->co_cookie, 0 );
+	*co->co_cookie = cookie;
+	memset( &cookie, 0, sizeof( cookie ));
+
+done:
+	if ( !BER_BVISNULL( &ndn ) ) {
+		op->o_tmpfree( ndn.bv_val, op->o_tmpmemctx );
+		op->o_tmpfree( dn.bv_val, op->o_tmpmemctx );
+	}
+	ch_free( modvals );
+	if ( eber )
+		ber_free( eber, 0 );
+	slap_sync_cookie_free( &cookie, 0 );
+	ldap_controls_free( rctrls );
+	return rc;
+}
+
+/*
+ * While a delta-sync consumer is catching up, fold the changes that
+ * directly follow a modify in the change stream and target the same
+ * entry into that modify: later modifies are appended to its modlist,
+ * a delete replaces it. The net change is then applied, and the cookie
+ * advanced, once instead of once per change. The first change that
+ * can't be merged is left in co->co_next for do_syncrep2().
+ */
+static void
+syncrepl_coalesce(
+	syncinfo_t	*si,
+	Operation	*op,
+	Modifications	**modlist,
+	sync_coalesce	*co )
+{
+	struct timeval tout = { 0, 0 };
+	LDAPMessage *msg;
+	int n;
+
+	for ( n = 1; n < SYNC_COALESCE_MAX && op->o_tag == LDAP_REQ_MODIFY; n++ ) {
+		/* only what has already arrived */
+		if ( ldap_result( si->si_ld, si->si_msgid, LDAP_MSG_ONE,
+			&tout, &msg ) <= 0 )
+			break;
+		if ( syncrepl_coalesce_msg( si, op, msg, modlist, co ) ) {
+			co->co_next = msg;
+			break;
+		}
+		ldap_msgfree( msg );
+	}
+	if ( n > 1 ) {
+		Debug( LDAP_DEBUG_SYNC, "syncrepl_coalesce: %s "
+			"merged %d changes to %s\n",
+			si->si_ridtxt, n, op->o_req_dn.bv_val );
+	}
+}
+
 static int
 syncrepl_message_to_op(
 	syncinfo_t	*si,
 	Operation	*op,
 	LDAPMessage	*msg,
-	int do_lock
+	int do_lock,
+	sync_coalesce *co
 )
 {
 	BerElement	*ber = NULL;
@@ -3200,6 +3607,14 @@ syncrepl_message_to_op(
 	Debug( LDAP_DEBUG_SYNC, "syncrepl_message_to_op: %s tid %p\n",
 		si->si_ridtxt, (void *)op->o_tid );
 
+	/* delta-mpr conflict resolution needs the changes one by one */
+	if ( co && op->o_tag == LDAP_REQ_MODIFY && modlist && do_graduate &&
+		!op->o_relax && !SLAP_MULTIPROVIDER( si->si_wbe ) &&
+		syncrepl_catching_up( si, &op->o_csn ))
+	{
+		syncrepl_coalesce( si, op, &modlist, co );
+	}
+
 	switch( op->o_tag ) {
 	case LDAP_REQ_ADD:
 	case LDAP_REQ_MODIFY:
@@ -3971,7 +4386,42 @@ typedef struct dninfo {
 	AttributeDescription *newDesc;	/* for renames */
 } dninfo;
 
-#define HASHUUID	1
+/* The presentlist is bucketed on the first two bytes of the UUID;
+ * each bucket is a sorted array of the remaining UUIDLEN-2 bytes.
+ * That is all the storage a UUID needs, instead of a tree node plus
+ * a separate allocation per UUID, and with a few million entries the
+ * buckets stay short enough that inserting by memmove is cheap.
+ */
+#define PRESENT_BUCKETS	65536
+#define PRESENT_KEYLEN	(UUIDLEN-2)
+
+typedef struct presentbucket {
+	int pb_num;
+	int pb_max;
+	char *pb_keys;
+} presentbucket;
+
+/* Find the slot of key in the bucket, or where it would be inserted */
+static int
+presentbucket_search( presentbucket *pb, const char *key, int *found )
+{
+	int lo = 0, hi = pb->pb_num, mid, cmp;
+
+	*found = 0;
+	while ( lo < hi ) {
+		mid = ( lo + hi ) / 2;
+		cmp = memcmp( key, pb->pb_keys + mid * PRESENT_KEYLEN, PRESENT_KEYLEN );
+		if ( cmp == 0 ) {
+			*found = 1;
+			return mid;
+		}
+		if ( cmp < 0 )
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+	return lo;
+}
 
 /* return 1 if inserted, 0 otherwise */
 static int
@@ -3979,96 +4429,115 @@ presentlist_insert(
 	syncinfo_t* si,
 	struct berval *syncUUID )
 {
-	char *val;
-
-#ifdef HASHUUID
-	Avlnode **av;
+	presentbucket *pb;
 	unsigned short s;
+	int i, found;
 
 	if ( !si->si_presentlist )
-		si->si_presentlist = ch_calloc(65536, sizeof( Avlnode * ));
+		si->si_presentlist = ch_calloc( PRESENT_BUCKETS, sizeof( presentbucket ));
 
-	av = (Avlnode **)si->si_presentlist;
+	memcpy( &s, syncUUID->bv_val, 2 );
+	pb = &si->si_presentlist[s];
 
-	val = ch_malloc(UUIDLEN-2);
-	memcpy(&s, syncUUID->bv_val, 2);
-	memcpy(val, syncUUID->bv_val+2, UUIDLEN-2);
-
-	if ( ldap_avl_insert( &av[s], val,
-		syncuuid_cmp, ldap_avl_dup_error ) )
-	{
-		ch_free( val );
+	i = presentbucket_search( pb, syncUUID->bv_val+2, &found );
+	if ( found )
 		return 0;
-	}
-#else
-	val = ch_malloc(UUIDLEN);
-
-	AC_MEMCPY( val, syncUUID->bv_val, UUIDLEN );
 
-	if ( ldap_avl_insert( &si->si_presentlist, val,
-		syncuuid_cmp, ldap_avl_dup_error ) )
-	{
-		ch_free( val );
-		return 0;
+	if ( pb->pb_num == pb->pb_max ) {
+		pb->pb_max = pb->pb_max ? pb->pb_max * 2 : 4;
+		pb->pb_keys = ch_realloc( pb->pb_keys, pb->pb_max * PRESENT_KEYLEN );
 	}
-#endif
+	if ( i < pb->pb_num )
+		AC_MEMCPY( pb->pb_keys + ( i+1 ) * PRESENT_KEYLEN,
+			pb->pb_keys + i * PRESENT_KEYLEN,
+			( pb->pb_num - i ) * PRESENT_KEYLEN );
+	memcpy( pb->pb_keys + i * PRESENT_KEYLEN, syncUUID->bv_val+2, PRESENT_KEYLEN );
+	pb->pb_num++;
 
 	return 1;
 }
 
-static char *
+static int
 presentlist_find(
-	Avlnode *av,
+	presentbucket *pl,
 	struct berval *val )
 {
-#ifdef HASHUUID
-	Avlnode **a2 = (Avlnode **)av;
 	unsigned short s;
+	int found;
 
-	if (!av)
-		return NULL;
+	if ( !pl )
+		return 0;
 
-	memcpy(&s, val->bv_val, 2);
-	return ldap_avl_find( a2[s], val->bv_val+2, syncuuid_cmp );
-#else
-	return ldap_avl_find( av, val->bv_val, syncuuid_cmp );
-#endif
+	memcpy( &s, val->bv_val, 2 );
+	(void)presentbucket_search( &pl[s], val->bv_val+2, &found );
+	return found;
 }
 
 static int
-presentlist_free( Avlnode *av )
+presentlist_free( presentbucket *pl )
 {
-#ifdef HASHUUID
-	Avlnode **a2 = (Avlnode **)av;
 	int i, count = 0;
 
-	if ( av ) {
-		for (i=0; i<65536; i++) {
-			if (a2[i])
-				count += ldap_avl_free( a2[i], ch_free );
+	if ( pl ) {
+		for ( i = 0; i < PRESENT_BUCKETS; i++ ) {
+			count += pl[i].pb_num;
+			if ( pl[i].pb_keys )
+				ch_free( pl[i].pb_keys );
 		}
-		ch_free( av );
+		ch_free( pl );
 	}
 	return count;
-#else
-	return ldap_avl_free( av, ch_free );
-#endif
 }
 
 static void
 presentlist_delete(
-	Avlnode **av,
+	presentbucket *pl,
 	struct berval *val )
 {
-#ifdef HASHUUID
-	Avlnode **a2 = *(Avlnode ***)av;
+	presentbucket *pb;
 	unsigned short s;
+	int i, found;
+
+	memcpy( &s, val->bv_val, 2 );
+	pb = &pl[s];
+	i = presentbucket_search( pb, val->bv_val+2, &found );
+	if ( !found )
+		return;
+
+	pb->pb_num--;
+	if ( i < pb->pb_num )
+		AC_MEMCPY( pb->pb_keys + i * PRESENT_KEYLEN,
+			pb->pb_keys + ( i+1 ) * PRESENT_KEYLEN,
+			( pb->pb_num - i ) * PRESENT_KEYLEN );
+}
 
-	memcpy(&s, val->bv_val, 2);
-	ldap_avl_delete( &a2[s], val->bv_val+2, syncuuid_cmp );
-#else
-	ldap_avl_delete( av, val->bv_val, syncuuid_cmp );
-#endif
+/*
+ * Take back the presentlist insertions and refresh counts of a batch
+ * whose writes were discarded, since the refresh will send those
+ * entries again.
+ */
+static void
+syncrepl_txn_undo(
+	syncinfo_t *si )
+{
+	struct berval bv;
+	int i;
+
+	bv.bv_len = UUIDLEN;
+	if ( si->si_presentlist ) {
+		for ( i = 0; i < si->si_txn_nuuids; i++ ) {
+			bv.bv_val = si->si_txn_uuids + i * UUIDLEN;
+			presentlist_delete( si->si_presentlist, &bv );
+		}
+	}
+	si->si_txn_nuuids = 0;
+
+	ldap_pvt_thread_mutex_lock( &si->si_monitor_mutex );
+	si->si_refreshEntries -= si->si_txn_entries;
+	si->si_refreshPresentCnt -= si->si_txn_present;
+	ldap_pvt_thread_mutex_unlock( &si->si_monitor_mutex );
+	si->si_txn_entries = 0;
+	si->si_txn_present = 0;
 }
 
 static int
@@ -4099,12 +4568,38 @@ syncrepl_entry(
 		"syncrepl_entry: %s LDAP_RES_SEARCH_ENTRY(LDAP_SYNC_%s) csn=%s tid %p\n",
 		si->si_ridtxt, syncrepl_state2str( syncstate ), syncCSN ? syncCSN->bv_val : "(none)", (void *)op->o_tid );
 
+	if ( !si->si_refreshDone ) {
+		ldap_pvt_thread_mutex_lock( &si->si_monitor_mutex );
+		if ( syncstate == LDAP_SYNC_PRESENT ) {
+			si->si_refreshPresentCnt++;
+			if ( si->si_txn )
+				si->si_txn_present++;
+		} else {
+			si->si_refreshEntries++;
+			if ( si->si_txn )
+				si->si_txn_entries++;
+		}
+		ldap_pvt_thread_mutex_unlock( &si->si_monitor_mutex );
+	}
+
 	if (( syncstate == LDAP_SYNC_PRESENT || syncstate == LDAP_SYNC_ADD ) ) {
 		if ( !si->si_refreshPresent && !si->si_refreshDone ) {
 			syncuuid_inserted = presentlist_insert( si, syncUUID );
 		}
 	}
 
+	/* remember what to take back if the batch is aborted */
+	if ( syncuuid_inserted && si->si_txn ) {
+		if ( si->si_txn_nuuids == si->si_txn_maxuuids ) {
+			si->si_txn_maxuuids = si->si_txn_maxuuids ?
+				si->si_txn_maxuuids * 2 : si->si_refreshbatch;
+			si->si_txn_uuids = ch_realloc( si->si_txn_uuids,
+				si->si_txn_maxuuids * UUIDLEN );
+		}
+		memcpy( si->si_txn_uuids + si->si_txn_nuuids++ * UUIDLEN,
+			syncUUID->bv_val, UUIDLEN );
+	}
+
 	if ( syncstate == LDAP_SYNC_PRESENT ) {
 		return 0;
 	} else if ( syncstate != LDAP_SYNC_DELETE ) {
@@ -5790,7 +6285,7 @@ nonpresent_callback(
 	syncinfo_t *si = op->o_callback->sc_private;
 	Attribute *a;
 	int count = 0;
-	char *present_uuid = NULL;
+	int present_uuid = 0;
 	struct nonpresent_entry *np_entry;
 	struct sync_cookie *syncCookie = op->o_controls[slap_cids.sc_LDAPsync];
 
@@ -5818,7 +6313,7 @@ nonpresent_callback(
 			if ( a == NULL ) return 0;
 		}
 
-		if ( present_uuid == NULL ) {
+		if ( !present_uuid ) {
 			int covered = 1; /* covered by our new contextCSN? */
 
 			if ( !syncCookie )
@@ -5853,8 +6348,7 @@ nonpresent_callback(
 			}
 
 		} else {
-			presentlist_delete( &si->si_presentlist, &a->a_nvals[0] );
-			ch_free( present_uuid );
+			presentlist_delete( si->si_presentlist, &a->a_nvals[0] );
 		}
 	}
 	return LDAP_SUCCESS;
@@ -5963,16 +6457,6 @@ done:;
 	return new;
 }
 
-static int
-syncuuid_cmp( const void* v_uuid1, const void* v_uuid2 )
-{
-#ifdef HASHUUID
-	return ( memcmp( v_uuid1, v_uuid2, UUIDLEN-2 ));
-#else
-	return ( memcmp( v_uuid1, v_uuid2, UUIDLEN ));
-#endif
-}
-
 void
 syncinfo_free( syncinfo_t *sie, int free_all )
 {
@@ -6009,6 +6493,8 @@ syncinfo_free( syncinfo_t *sie, int free_all )
 
 		ldap_pvt_thread_mutex_destroy( &sie->si_mutex );
 		ldap_pvt_thread_mutex_destroy( &sie->si_monitor_mutex );
+		ch_free( sie->si_conflicts );
+		ch_free( sie->si_txn_uuids );
 
 		bindconf_free( &sie->si_bindconf );
 
@@ -6185,6 +6671,8 @@ config_suffixm( ConfigArgs *c, syncinfo_t *si )
 #define SUFFIXMSTR		"suffixmassage"
 #define	STRICT_REFRESH	"strictrefresh"
 #define LAZY_COMMIT		"lazycommit"
+#define CATCHUPSTR		"catchup"
+#define REFRESHBATCHSTR	"refreshbatch"
 
 /* FIXME: undocumented */
 #define EXATTRSSTR		"exattrs"
@@ -6712,6 +7200,33 @@ parse_syncrepl_line(
 					STRLENOF( LAZY_COMMIT ) ) )
 		{
 			si->si_lazyCommit = 1;
+		} else if ( !strncasecmp( c->argv[ i ], CATCHUPSTR "=",
+					STRLENOF( CATCHUPSTR "=" ) ) )
+		{
+			unsigned long	t;
+
+			val = c->argv[ i ] + STRLENOF( CATCHUPSTR "=" );
+			if ( lutil_parse_time( val, &t ) != 0 ) {
+				snprintf( c->cr_msg, sizeof( c->cr_msg ),
+					"Error: parse_syncrepl_line: "
+					"invalid catchup \"%s\"", val );
+				Debug( LDAP_DEBUG_ANY, "%s: %s.\n", c->log, c->cr_msg );
+				return -1;
+			}
+			si->si_catchup = (time_t)t;
+		} else if ( !strncasecmp( c->argv[ i ], REFRESHBATCHSTR "=",
+					STRLENOF( REFRESHBATCHSTR "=" ) ) )
+		{
+			val = c->argv[ i ] + STRLENOF( REFRESHBATCHSTR "=" );
+			if ( lutil_atoi( &si->si_refreshbatch, val ) != 0 ||
+				si->si_refreshbatch < 0 )
+			{
+				snprintf( c->cr_msg, sizeof( c->cr_msg ),
+					"Error: parse_syncrepl_line: "
+					"invalid refreshbatch \"%s\"", val );
+				Debug( LDAP_DEBUG_ANY, "%s: %s.\n", c->log, c->cr_msg );
+				return -1;
+			}
 		} else if ( !bindconf_parse( c->argv[i], &si->si_bindconf ) ) {
 			si->si_got |= GOT_BINDCONF;
 		} else {
@@ -6793,7 +7308,9 @@ static ObjectClass	*oc_olmSyncRepl;
 static AttributeDescription	*ad_olmProviderURIList,
 	*ad_olmConnection, *ad_olmSyncPhase,
 	*ad_olmNextConnect, *ad_olmLastConnect, *ad_olmLastContact,
-	*ad_olmLastCookieRcvd, *ad_olmLastCookieSent;
+	*ad_olmLastCookieRcvd, *ad_olmLastCookieSent,
+	*ad_olmRefreshStart, *ad_olmRefreshEntries, *ad_olmRefreshPresent,
+	*ad_olmConflicts, *ad_olmConflictSids;
 
 static struct {
 	char *name;
@@ -6869,6 +7386,42 @@ static struct {
 		"NO-USER-MODIFICATION "
 		"USAGE dSAOperation )",
 		&ad_olmLastCookieSent },
+	{ "( olmSyncReplAttributes:9 "
+		"NAME ( 'olmSRRefreshStart' ) "
+		"DESC 'Time the current or last refresh phase started' "
+		"SUP monitorTimestamp "
+		"SINGLE-VALUE "
+		"NO-USER-MODIFICATION "
+		"USAGE dSAOperation )",
+		&ad_olmRefreshStart },
+	{ "( olmSyncReplAttributes:10 "
+		"NAME ( 'olmSRRefreshEntries' ) "
+		"DESC 'Entries received in the current or last refresh phase' "
+		"SUP monitorCounter "
+		"NO-USER-MODIFICATION "
+		"USAGE dSAOperation )",
+		&ad_olmRefreshEntries },
+	{ "( olmSyncReplAttributes:11 "
+		"NAME ( 'olmSRRefreshPresent' ) "
+		"DESC 'Entries reported present in the current or last refresh phase' "
+		"SUP monitorCounter "
+		"NO-USER-MODIFICATION "
+		"USAGE dSAOperation )",
+		&ad_olmRefreshPresent },
+	{ "( olmSyncReplAttributes:12 "
+		"NAME ( 'olmSRConflicts' ) "
+		"DESC 'Received modifies resolved against newer changes by CSN order' "
+		"SUP monitorCounter "
+		"NO-USER-MODIFICATION "
+		"USAGE dSAOperation )",
+		&ad_olmConflicts },
+	{ "( olmSyncReplAttributes:13 "
+		"NAME ( 'olmSRConflictSids' ) "
+		"DESC 'Resolved conflicts per pair of older and newer serverIDs' "
+		"SUP monitoredInfo "
+		"NO-USER-MODIFICATION "
+		"USAGE dSAOperation )",
+		&ad_olmConflictSids },
 	{ NULL }
 };
 
@@ -6888,6 +7441,11 @@ static struct {
 			"$ olmSRLastContact "
 			"$ olmSRLastCookieRcvd "
 			"$ olmSRLastCookieSent "
+			"$ olmSRRefreshStart "
+			"$ olmSRRefreshEntries "
+			"$ olmSRRefreshPresent "
+			"$ olmSRConflicts "
+			"$ olmSRConflictSids "
 			") )",
 		&oc_olmSyncRepl },
 	{ NULL }
@@ -7065,6 +7623,82 @@ syncrepl_monitor_update(
 		ber_bvreplace( &a->a_vals[0], &si->si_lastCookieSent );
 	ldap_pvt_thread_mutex_unlock( &si->si_monitor_mutex );
 
+	a = a->a_next;
+	if ( a->a_desc != ad_olmRefreshStart )
+		return SLAP_CB_CONTINUE;
+
+	{
+		char buf[ LDAP_PVT_INTTYPE_CHARS(unsigned long) ];
+		struct berval bv;
+		time_t refreshStart;
+		unsigned long refreshEntries, refreshPresent, conflicts;
+
+		ldap_pvt_thread_mutex_lock( &si->si_monitor_mutex );
+		refreshStart = si->si_refreshStart;
+		refreshEntries = si->si_refreshEntries;
+		refreshPresent = si->si_refreshPresentCnt;
+		conflicts = si->si_conflictsTotal;
+		ldap_pvt_thread_mutex_unlock( &si->si_monitor_mutex );
+
+		if ( refreshStart ) {
+			struct tm tm;
+			char tmbuf[ LDAP_LUTIL_GENTIME_BUFSIZE ];
+			ber_len_t len;
+
+			ldap_pvt_gmtime( &refreshStart, &tm );
+			lutil_gentime( tmbuf, sizeof( tmbuf ), &tm );
+			len = strlen( tmbuf );
+			assert( len == a->a_vals[0].bv_len );
+			AC_MEMCPY( a->a_vals[0].bv_val, tmbuf, len );
+		}
+
+		a = a->a_next;
+		if ( a->a_desc != ad_olmRefreshEntries )
+			return SLAP_CB_CONTINUE;
+
+		bv.bv_val = buf;
+		bv.bv_len = snprintf( buf, sizeof( buf ), "%lu", refreshEntries );
+		ber_bvreplace( &a->a_vals[0], &bv );
+
+		a = a->a_next;
+		if ( a->a_desc != ad_olmRefreshPresent )
+			return SLAP_CB_CONTINUE;
+
+		bv.bv_len = snprintf( buf, sizeof( buf ), "%lu", refreshPresent );
+		ber_bvreplace( &a->a_vals[0], &bv );
+
+		a = a->a_next;
+		if ( a->a_desc != ad_olmConflicts )
+			return SLAP_CB_CONTINUE;
+
+		bv.bv_len = snprintf( buf, sizeof( buf ), "%lu", conflicts );
+		ber_bvreplace( &a->a_vals[0], &bv );
+	}
+
+	/* one value per serverID pair seen so far */
+	ldap_pvt_thread_mutex_lock( &si->si_monitor_mutex );
+	if ( si->si_numconflicts ) {
+		char buf[ sizeof("older= newer= count=") +
+			2*LDAP_PVT_INTTYPE_CHARS(int) + LDAP_PVT_INTTYPE_CHARS(unsigned long) ];
+		BerVarray vals;
+		int i;
+
+		vals = ch_malloc( ( si->si_numconflicts + 1 ) * sizeof( struct berval ));
+		for ( i = 0; i < si->si_numconflicts; i++ ) {
+			vals[i].bv_len = snprintf( buf, sizeof( buf ),
+				"older=%d newer=%d count=%lu",
+				si->si_conflicts[i].cf_sids >> 12,
+				si->si_conflicts[i].cf_sids & SLAP_SYNC_SID_MAX,
+				si->si_conflicts[i].cf_count );
+			vals[i].bv_val = ch_strdup( buf );
+		}
+		BER_BVZERO( &vals[i] );
+		attr_delete( &e->e_attrs, ad_olmConflictSids );
+		attr_merge( e, ad_olmConflictSids, vals, NULL );
+		ber_bvarray_free( vals );
+	}
+	ldap_pvt_thread_mutex_unlock( &si->si_monitor_mutex );
+
 	return SLAP_CB_CONTINUE;
 }
 
@@ -7142,6 +7776,13 @@ syncrepl_monitor_add(
 		attr_merge_normalize_one( e, ad_olmLastCookieRcvd, &bv, NULL );
 		attr_merge_normalize_one( e, ad_olmLastCookieSent, &bv, NULL );
 	}
+	{
+		struct berval bv = BER_BVC("0");
+		attr_merge_normalize_one( e, ad_olmRefreshStart, (struct berval *)&zerotime, NULL );
+		attr_merge_one( e, ad_olmRefreshEntries, &bv, NULL );
+		attr_merge_one( e, ad_olmRefreshPresent, &bv, NULL );
+		attr_merge_one( e, ad_olmConflicts, &bv, NULL );
+	}
 	{
 		monitor_callback_t *cb = ch_calloc( sizeof( monitor_callback_t ), 1 );
 		cb->mc_update = syncrepl_monitor_update;
@@ -7532,6 +8173,20 @@ syncrepl_unparse( syncinfo_t *si, struct berval *bv )
 		ptr = lutil_strcopy( ptr, " " LAZY_COMMIT );
 	}
 
+	if ( si->si_catchup ) {
+		len = snprintf( ptr, WHATSLEFT, " " CATCHUPSTR "=%ld",
+			(long) si->si_catchup );
+		if ( WHATSLEFT <= len ) return;
+		ptr += len;
+	}
+
+	if ( si->si_refreshbatch ) {
+		len = snprintf( ptr, WHATSLEFT, " " REFRESHBATCHSTR "=%d",
+			si->si_refreshbatch );
+		if ( WHATSLEFT <= len ) return;
+		ptr += len;
+	}
+
 	bc.bv_len = ptr - buf;
 	bc.bv_val = buf;
 	ber_dupbv( bv, &bc );
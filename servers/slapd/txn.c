@@ -295,6 +295,9 @@ int txn_end_extop(
 		if ( rc ) {
 			rs->sr_text = "transaction commit failed";
 			rc = LDAP_OTHER;
+		} else {
+			/* results were sent before the writes became visible */
+			slap_group_cache_flush();
 		}
 	} else {
 		rs->sr_text = "transaction aborted";